@@ -6,6 +6,7 @@
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx11.h"
 #include "../main.h"
+#include "../latency.h"
 #include <d3d11.h>
 #define DIRECTINPUT_VERSION 0x0800
 #include <dinput.h>
@@ -102,6 +103,8 @@ int main(int, char**)
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     app::init();
+    static DWORD mainThreadId = ::GetCurrentThreadId();
+    app::setWakeHandler([] { ::PostThreadMessage(mainThreadId, WM_NULL, 0, 0); });
 
     // Main loop
     MSG msg;
@@ -115,6 +118,8 @@ int main(int, char**)
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
         if (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
         {
+            if ((msg.message >= WM_MOUSEFIRST && msg.message <= WM_MOUSELAST) || (msg.message >= WM_KEYFIRST && msg.message <= WM_KEYLAST))
+                editorui::latency::inputReceived();
             ::TranslateMessage(&msg);
             ::DispatchMessage(&msg);
             continue;
@@ -132,6 +137,7 @@ int main(int, char**)
         g_pd3dDeviceContext->OMSetRenderTargets(1, &g_mainRenderTargetView, NULL);
         g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView, (float*)&clear_color);
         ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+        editorui::latency::frameRendered();
 
         // Update and Render additional Platform Windows
         if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
@@ -142,6 +148,11 @@ int main(int, char**)
 
         g_pSwapChain->Present(1, 0); // Present with vsync
         //g_pSwapChain->Present(0, 0); // Present without vsync
+        editorui::latency::framePresented();
+
+        // Render on demand: when nothing needs a frame, sleep until input, a repaint request or the idle timeout.
+        if (!app::needsFrame())
+            ::MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)(app::IDLE_TIMEOUT_SECONDS * 1000), QS_ALLINPUT);
     }
 
     app::quit();
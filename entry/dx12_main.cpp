@@ -7,6 +7,7 @@
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx12.h"
 #include "../main.h"
+#include "../latency.h"
 #include <d3d12.h>
 #include <dxgi1_4.h>
 #include <tchar.h>
@@ -127,6 +128,8 @@ int main(int, char**)
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     app::init();
+    static DWORD mainThreadId = ::GetCurrentThreadId();
+    app::setWakeHandler([] { ::PostThreadMessage(mainThreadId, WM_NULL, 0, 0); });
 
     // Main loop
     MSG msg;
@@ -140,6 +143,8 @@ int main(int, char**)
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
         if (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
         {
+            if ((msg.message >= WM_MOUSEFIRST && msg.message <= WM_MOUSELAST) || (msg.message >= WM_KEYFIRST && msg.message <= WM_KEYLAST))
+                editorui::latency::inputReceived();
             ::TranslateMessage(&msg);
             ::DispatchMessage(&msg);
             continue;
@@ -172,6 +177,7 @@ int main(int, char**)
         g_pd3dCommandList->SetDescriptorHeaps(1, &g_pd3dSrvDescHeap);
         ImGui::Render();
         ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), g_pd3dCommandList);
+        editorui::latency::frameRendered();
         barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
         barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_PRESENT;
         g_pd3dCommandList->ResourceBarrier(1, &barrier);
@@ -188,11 +194,16 @@ int main(int, char**)
 
         g_pSwapChain->Present(1, 0); // Present with vsync
         //g_pSwapChain->Present(0, 0); // Present without vsync
+        editorui::latency::framePresented();
 
         UINT64 fenceValue = g_fenceLastSignaledValue + 1;
         g_pd3dCommandQueue->Signal(g_fence, fenceValue);
         g_fenceLastSignaledValue = fenceValue;
         frameCtxt->FenceValue = fenceValue;
+
+        // Render on demand: when nothing needs a frame, sleep until input, a repaint request or the idle timeout.
+        if (!app::needsFrame())
+            ::MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)(app::IDLE_TIMEOUT_SECONDS * 1000), QS_ALLINPUT);
     }
 
     app::quit();
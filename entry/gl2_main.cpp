@@ -11,6 +11,7 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl2.h"
 #include "../main.h"
+#include "../latency.h"
 #include <stdio.h>
 #ifdef __APPLE__
 #define GL_SILENCE_DEPRECATION
@@ -65,6 +66,13 @@ int main(int, char**)
     }
 
     // Setup Platform/Renderer backends
+    // Timestamp input for latency measurement. Installed before the ImGui backend, which chains to these
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { editorui::latency::inputReceived(); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { editorui::latency::inputReceived(); });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { editorui::latency::inputReceived(); });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { editorui::latency::inputReceived(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { editorui::latency::inputReceived(); });
+
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL2_Init();
 
@@ -89,6 +97,7 @@ int main(int, char**)
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     app::init();
+    app::setWakeHandler([] { glfwPostEmptyEvent(); });
 
     // Main loop
     while (!glfwWindowShouldClose(window))
@@ -98,7 +107,11 @@ int main(int, char**)
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-        glfwPollEvents();
+        // Render on demand: when nothing needs a frame, sleep until input, a repaint request or the idle timeout.
+        if (app::needsFrame())
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(app::IDLE_TIMEOUT_SECONDS);
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL2_NewFrame();
@@ -121,6 +134,7 @@ int main(int, char**)
         //glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
         //glUseProgram(0);
         ImGui_ImplOpenGL2_RenderDrawData(ImGui::GetDrawData());
+        editorui::latency::frameRendered();
         //glUseProgram(last_program);
 
         // Update and Render additional Platform Windows
@@ -135,6 +149,7 @@ int main(int, char**)
         }
 
         glfwSwapBuffers(window);
+        editorui::latency::framePresented();
     }
 
     app::quit();
@@ -7,6 +7,7 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include "../main.h"
+#include "../latency.h"
 #include <stdio.h>
 
 // About Desktop OpenGL function loaders:
@@ -129,6 +130,13 @@ int main(int, char**)
     }
 
     // Setup Platform/Renderer backends
+    // Timestamp input for latency measurement. Installed before the ImGui backend, which chains to these
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { editorui::latency::inputReceived(); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { editorui::latency::inputReceived(); });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { editorui::latency::inputReceived(); });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { editorui::latency::inputReceived(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { editorui::latency::inputReceived(); });
+
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
@@ -153,6 +161,7 @@ int main(int, char**)
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     app::init();
+    app::setWakeHandler([] { glfwPostEmptyEvent(); });
 
     // Main loop
     while (!glfwWindowShouldClose(window))
@@ -162,7 +171,11 @@ int main(int, char**)
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-        glfwPollEvents();
+        // Render on demand: when nothing needs a frame, sleep until input, a repaint request or the idle timeout.
+        if (app::needsFrame())
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(app::IDLE_TIMEOUT_SECONDS);
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -179,6 +192,7 @@ int main(int, char**)
         glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        editorui::latency::frameRendered();
     	
         // Update and Render additional Platform Windows
         // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
@@ -192,6 +206,7 @@ int main(int, char**)
         }
 
         glfwSwapBuffers(window);
+        editorui::latency::framePresented();
     }
 
     app::quit();
@@ -0,0 +1,276 @@
+// Headless entry: drives the app with a null renderer and synthetic input.
+// No window, no GPU - meant for measuring editorui::edit on CI machines.
+// With --replay, input comes from a session recorded with Tools > Record Input instead,
+// and the final graph is checked against the end of the recording.
+//
+// usage: nodegrapher [--frames N] [--width W] [--height H] [--csv path] [--replay session.json]
+
+#include "imgui.h"
+#include "../main.h"
+#include "../inputsession.h"
+#include "../latency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// Allocation counting
+// Every heap allocation made through operator new is counted, ImGui's own allocations
+// go through the allocator functions below so they can be told apart.
+static std::atomic<size_t> g_heapAllocCount{0};
+static std::atomic<size_t> g_imguiAllocCount{0};
+
+void* operator new(size_t size)
+{
+    ++g_heapAllocCount;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static void* CountingMemAlloc(size_t size, void*)
+{
+    ++g_imguiAllocCount;
+    return std::malloc(size);
+}
+static void CountingMemFree(void* ptr, void*)
+{
+    std::free(ptr);
+}
+
+struct FrameRecord
+{
+    double frameMs;     // NewFrame .. Render
+    double editMs;      // app::update, i.e. editorui::edit
+    int    vertices;
+    int    indices;
+    size_t heapAllocs;  // operator new calls during app::update
+    size_t imguiAllocs; // ImGui allocations during the whole frame
+};
+
+// Synthetic input: a fixed, frame-indexed script so that runs are comparable.
+// Cycles through hovering, left-dragging (node drag / box select), middle-dragging (pan)
+// and wheel zoom over the display area.
+static void FeedSyntheticInput(ImGuiIO& io, int frame)
+{
+    const float t = frame / 60.0f;
+    const float w = io.DisplaySize.x, h = io.DisplaySize.y;
+    io.MousePos = ImVec2(w * (0.5f + 0.35f * sinf(t * 0.9f)), h * (0.5f + 0.35f * sinf(t * 1.3f + 0.5f)));
+    for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); i++)
+        io.MouseDown[i] = false;
+    io.MouseWheel = 0.0f;
+
+    const int phase = (frame / 120) % 4;
+    const int step = frame % 120;
+    switch (phase)
+    {
+    case 0: // hover only
+        break;
+    case 1: // left drag
+        io.MouseDown[0] = step > 10 && step < 110;
+        break;
+    case 2: // middle drag (pan)
+        io.MouseDown[2] = step > 10 && step < 110;
+        break;
+    case 3: // zoom in, then out again
+        if (step % 10 == 0)
+            io.MouseWheel = step < 60 ? 1.0f : -1.0f;
+        break;
+    }
+}
+
+static double Percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t idx = std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5));
+    return values[idx];
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 600;
+    int width = 1280, height = 800;
+    const char* csvPath = NULL;
+    const char* replayPath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+            width = std::max(64, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+            height = std::max(64, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+    }
+
+    editorui::session::Replay replay;
+    if (replayPath)
+    {
+        std::string error;
+        if (!replay.load(replayPath, &error))
+        {
+            fprintf(stderr, "cannot load recording \"%s\": %s\n", replayPath, error.c_str());
+            return 1;
+        }
+        frames = replay.frameCount();
+        width = (int)replay.displaySize().x;
+        height = (int)replay.displaySize().y;
+    }
+
+    // Setup Dear ImGui context
+    IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(CountingMemAlloc, CountingMemFree, NULL);
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
+    io.IniFilename = NULL;                                      // Runs must not depend on a previous layout
+    io.DisplaySize = ImVec2((float)width, (float)height);
+    io.DeltaTime = 1.0f / 60.0f;
+    io.BackendPlatformName = "headless";
+    io.BackendRendererName = "null";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;  // We never draw, so large meshes are fine
+
+    app::init();
+    if (replayPath && !replay.restore(app::graph))
+    {
+        fprintf(stderr, "recording \"%s\" has no initial state\n", replayPath);
+        return 1;
+    }
+
+    // Null renderer: the font atlas still has to be built, but is never uploaded anywhere
+    unsigned char* pixels = NULL;
+    int texWidth = 0, texHeight = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &texWidth, &texHeight);
+    io.Fonts->SetTexID((ImTextureID)(intptr_t)1);
+
+    std::vector<FrameRecord> records;
+    records.reserve(frames);
+    using Clock = std::chrono::steady_clock;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        if (replayPath)
+        {
+            // as while recording: link paths are complete before each frame, so that what
+            // replayed clicks & cuts hit does not depend on the timing of the worker thread
+            app::graph.finishLinkPaths();
+            replay.feed(io, frame);
+        }
+        else
+            FeedSyntheticInput(io, frame);
+        editorui::latency::inputReceived(); // every frame carries input here
+
+        const size_t imguiAllocsBefore = g_imguiAllocCount;
+        const Clock::time_point frameStart = Clock::now();
+        ImGui::NewFrame();
+
+        const size_t heapAllocsBefore = g_heapAllocCount;
+        const Clock::time_point editStart = Clock::now();
+        app::update();
+        const Clock::time_point editEnd = Clock::now();
+        const size_t heapAllocsAfter = g_heapAllocCount;
+
+        ImGui::Render();
+        const Clock::time_point frameEnd = Clock::now();
+        editorui::latency::frameRendered(); // null renderer: rendered & presented right away
+        editorui::latency::framePresented();
+
+        ImDrawData* drawData = ImGui::GetDrawData();
+        FrameRecord rec;
+        rec.frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+        rec.editMs = std::chrono::duration<double, std::milli>(editEnd - editStart).count();
+        rec.vertices = drawData ? drawData->TotalVtxCount : 0;
+        rec.indices = drawData ? drawData->TotalIdxCount : 0;
+        rec.heapAllocs = heapAllocsAfter - heapAllocsBefore;
+        rec.imguiAllocs = g_imguiAllocCount - imguiAllocsBefore;
+        records.push_back(rec);
+    }
+
+    const editorui::latency::Stats latency = editorui::latency::inputToPresent();
+    std::string mismatch;
+    const bool replayMatches = !replayPath || replay.verify(app::graph, &mismatch);
+
+    app::quit();
+    ImGui::DestroyContext();
+
+    if (csvPath)
+    {
+        if (FILE* csv = fopen(csvPath, "w"))
+        {
+            fprintf(csv, "frame,frame_ms,edit_ms,vertices,indices,heap_allocs,imgui_allocs\n");
+            for (size_t i = 0; i < records.size(); i++)
+                fprintf(csv, "%zu,%.4f,%.4f,%d,%d,%zu,%zu\n", i, records[i].frameMs, records[i].editMs,
+                        records[i].vertices, records[i].indices, records[i].heapAllocs, records[i].imguiAllocs);
+            fclose(csv);
+        }
+        else
+        {
+            fprintf(stderr, "cannot open \"%s\" for writing\n", csvPath);
+        }
+    }
+
+    std::vector<double> frameMs, editMs;
+    double vertices = 0, indices = 0, heapAllocs = 0, imguiAllocs = 0;
+    for (const FrameRecord& rec : records)
+    {
+        frameMs.push_back(rec.frameMs);
+        editMs.push_back(rec.editMs);
+        vertices += rec.vertices;
+        indices += rec.indices;
+        heapAllocs += (double)rec.heapAllocs;
+        imguiAllocs += (double)rec.imguiAllocs;
+    }
+    const double n = (double)records.size();
+    printf("frames           : %d (%dx%d)\n", frames, width, height);
+    if (!records.empty()) // e.g. a recording without frames
+    {
+        printf("frame ms         : p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+               Percentile(frameMs, 0.5), Percentile(frameMs, 0.95), Percentile(frameMs, 0.99), Percentile(frameMs, 1.0));
+        printf("edit ms          : p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+               Percentile(editMs, 0.5), Percentile(editMs, 0.95), Percentile(editMs, 0.99), Percentile(editMs, 1.0));
+    }
+    printf("input latency ms : p50 %.3f  p90 %.3f  p99 %.3f  max %.3f (last %zu frames)\n",
+           latency.p50Ms, latency.p90Ms, latency.p99Ms, latency.maxMs, latency.samples);
+    if (!records.empty())
+    {
+        printf("vertices / frame : %.0f\n", vertices / n);
+        printf("indices / frame  : %.0f\n", indices / n);
+        printf("heap allocs      : %.1f / frame (in edit)\n", heapAllocs / n);
+        printf("imgui allocs     : %.1f / frame\n", imguiAllocs / n);
+    }
+    if (replayPath)
+        printf("replay           : %s%s\n", replayMatches ? "final graph matches the recording" : "MISMATCH, ", mismatch.c_str());
+
+    return replayMatches ? 0 : 1;
+}
@@ -13,6 +13,7 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_vulkan.h"
 #include "../main.h"
+#include "../latency.h"
 #include <stdio.h>          // printf, fprintf
 #include <stdlib.h>         // abort
 #define GLFW_INCLUDE_NONE
@@ -396,6 +397,13 @@ int main(int, char**)
     }
 
     // Setup Platform/Renderer backends
+    // Timestamp input for latency measurement. Installed before the ImGui backend, which chains to these
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double) { editorui::latency::inputReceived(); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int) { editorui::latency::inputReceived(); });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double) { editorui::latency::inputReceived(); });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int) { editorui::latency::inputReceived(); });
+    glfwSetCharCallback(window, [](GLFWwindow*, unsigned int) { editorui::latency::inputReceived(); });
+
     ImGui_ImplGlfw_InitForVulkan(window, true);
     ImGui_ImplVulkan_InitInfo init_info = {};
     init_info.Instance = g_Instance;
@@ -462,6 +470,7 @@ int main(int, char**)
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     app::init();
+    app::setWakeHandler([] { glfwPostEmptyEvent(); });
 
     // Main loop
     while (!glfwWindowShouldClose(window))
@@ -471,7 +480,11 @@ int main(int, char**)
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-        glfwPollEvents();
+        // Render on demand: when nothing needs a frame, sleep until input, a repaint request or the idle timeout.
+        if (app::needsFrame())
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(app::IDLE_TIMEOUT_SECONDS);
 
         // Resize swap chain?
         if (g_SwapChainRebuild)
@@ -500,7 +513,10 @@ int main(int, char**)
         const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
         memcpy(&wd->ClearValue.color.float32[0], &clear_color, 4 * sizeof(float));
         if (!main_is_minimized)
+        {
             FrameRender(wd, main_draw_data);
+            editorui::latency::frameRendered();
+        }
 
         // Update and Render additional Platform Windows
         if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
@@ -511,7 +527,10 @@ int main(int, char**)
 
         // Present Main Platform Window
         if (!main_is_minimized)
+        {
             FramePresent(wd);
+            editorui::latency::framePresented();
+        }
     }
 
     app::quit();
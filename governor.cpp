@@ -0,0 +1,152 @@
+#include "governor.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace editorui {
+namespace governor {
+
+namespace {
+
+// frames looked at before each decision, and since each tier change
+constexpr int WINDOW_FRAMES = 30;
+
+// frames well below target needed before stepping up, doubled each time a step up had to be
+// taken back soon after, so that a tier on the edge does not flicker
+constexpr int MIN_CALM_FRAMES = 120;
+constexpr int MAX_CALM_FRAMES = 120 * 16;
+
+// stepping up needs frames below this fraction of the target, dropping a tier roughly halves
+// the drawing work
+constexpr double UP_RATIO = 0.5;
+
+// everything happens on the thread running the main loop
+struct State
+{
+  bool                             enabled    = true;
+  double                           targetMs   = 16.0;
+  Tier                             tier       = Tier::FULL;
+  std::array<float, WINDOW_FRAMES> window     = {};
+  int                              size       = 0; // frames in window since last change
+  int                              head       = 0;
+  int                              calmFrames = 0; // consecutive frames under UP_RATIO
+  int                              calmNeeded = MIN_CALM_FRAMES;
+  int                              sinceUp    = -1; // frames since the last step up
+};
+
+State& state()
+{
+  static State s;
+  return s;
+}
+
+double median(State const& s)
+{
+  if (s.size == 0)
+    return 0;
+  std::array<float, WINDOW_FRAMES> sorted = s.window;
+  std::nth_element(sorted.begin(), sorted.begin() + s.size / 2, sorted.begin() + s.size);
+  return sorted[s.size / 2];
+}
+
+void changeTier(State& s, Tier tier)
+{
+  s.tier       = tier;
+  s.size       = 0;
+  s.head       = 0;
+  s.calmFrames = 0;
+  trace::counter("quality tier", int64_t(tier));
+}
+
+} // namespace
+
+char const* tierName(Tier tier)
+{
+  switch (tier) {
+  case Tier::FULL:
+    return "Full";
+  case Tier::REDUCED:
+    return "Reduced";
+  case Tier::LOW:
+    return "Low";
+  case Tier::MINIMAL:
+    return "Minimal";
+  }
+  return "?";
+}
+
+bool enabled()
+{
+  return state().enabled;
+}
+
+void setEnabled(bool enabled)
+{
+  auto& s = state();
+  if (s.enabled == enabled)
+    return;
+  s.enabled = enabled;
+  reset();
+}
+
+double targetMs()
+{
+  return state().targetMs;
+}
+
+void setTargetMs(double ms)
+{
+  state().targetMs = std::max(1.0, ms);
+}
+
+void frameTime(double ms)
+{
+  auto& s = state();
+  if (!s.enabled)
+    return;
+  s.window[s.head] = float(ms);
+  s.head           = (s.head + 1) % WINDOW_FRAMES;
+  s.size           = std::min(s.size + 1, WINDOW_FRAMES);
+  if (s.sinceUp >= 0)
+    ++s.sinceUp;
+  s.calmFrames = ms < s.targetMs * UP_RATIO ? s.calmFrames + 1 : 0;
+  if (s.size < WINDOW_FRAMES)
+    return;
+
+  if (median(s) > s.targetMs && s.tier != Tier::MINIMAL) {
+    // going back down right after going up: ask for more calm next time
+    if (s.sinceUp >= 0 && s.sinceUp <= 2 * WINDOW_FRAMES)
+      s.calmNeeded = std::min(s.calmNeeded * 2, MAX_CALM_FRAMES);
+    else if (s.sinceUp > 4 * s.calmNeeded) // the last step up held for long, forgive
+      s.calmNeeded = MIN_CALM_FRAMES;
+    s.sinceUp = -1;
+    changeTier(s, Tier(int(s.tier) + 1));
+  } else if (s.calmFrames >= s.calmNeeded && s.tier != Tier::FULL) {
+    s.sinceUp = 0;
+    changeTier(s, Tier(int(s.tier) - 1));
+  }
+}
+
+Tier tier()
+{
+  auto const& s = state();
+  return s.enabled ? s.tier : Tier::FULL;
+}
+
+double recentMs()
+{
+  return median(state());
+}
+
+void reset()
+{
+  auto& s      = state();
+  s.calmNeeded = MIN_CALM_FRAMES;
+  s.sinceUp    = -1;
+  changeTier(s, Tier::FULL);
+}
+
+} // namespace governor
+} // namespace editorui
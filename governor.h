@@ -0,0 +1,40 @@
+#pragma once
+// frame-time governor: steps rendering quality down while frames take longer than a target,
+// and back up once they are well below it again
+// no ImGui in here - edit() feeds it, drawGraph() asks it what to draw
+
+namespace editorui {
+namespace governor {
+
+/// what each tier leaves out adds up, MINIMAL draws the least
+enum class Tier : int
+{
+  FULL,    // everything
+  REDUCED, // no hook overlays (onNodeDraw), fewer circle segments
+  LOW,     // also no icons, links drawn as straight lines
+  MINIMAL, // also no names and no pins
+};
+
+char const* tierName(Tier tier);
+
+/// while disabled the tier is FULL (enabled by default)
+bool enabled();
+void setEnabled(bool enabled);
+
+/// frames are compared against this, 16 ms by default
+double targetMs();
+void   setTargetMs(double ms);
+
+/// feeds the time the UI took in one frame, waits for vsync or input excluded
+void frameTime(double ms);
+
+Tier tier();
+
+/// median of the frames seen since the last tier change, 0 if none
+double recentMs();
+
+/// back to FULL, forgets the frames seen so far
+void reset();
+
+} // namespace governor
+} // namespace editorui
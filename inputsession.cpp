@@ -0,0 +1,301 @@
+#include "inputsession.h"
+
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace editorui {
+namespace session {
+
+namespace {
+
+constexpr int FORMAT_VERSION = 1;
+
+struct Recorder
+{
+  Graph const*            graph   = nullptr;
+  bool                    active  = false;
+  bool                    started = false; // initial state captured
+  nlohmann::json          initial;
+  nlohmann::json          final;
+  std::vector<InputFrame> frames;
+};
+
+Recorder& recorder()
+{
+  static Recorder r;
+  return r;
+}
+
+// zero fields are left out, most frames only move the mouse
+nlohmann::json frameToJson(InputFrame const& f, InputFrame const* prev)
+{
+  nlohmann::json js = {{"dt", f.deltaTime}, {"mouse", {f.mousePos.x, f.mousePos.y}}};
+  if (!prev || prev->displaySize != f.displaySize)
+    js["display"] = {f.displaySize.x, f.displaySize.y};
+  if (f.mouseButtons)
+    js["buttons"] = f.mouseButtons;
+  if (f.mouseWheel != 0)
+    js["wheel"] = f.mouseWheel;
+  if (f.mouseWheelH != 0)
+    js["wheelH"] = f.mouseWheelH;
+  if (f.modifiers)
+    js["mods"] = f.modifiers;
+  if (!f.keysDown.empty())
+    js["keys"] = f.keysDown;
+  if (!f.characters.empty())
+    js["chars"] = f.characters;
+  return js;
+}
+
+InputFrame frameFromJson(nlohmann::json const& js, InputFrame const* prev)
+{
+  InputFrame f;
+  f.deltaTime   = js.at("dt");
+  f.mousePos    = {js.at("mouse")[0], js.at("mouse")[1]};
+  f.displaySize = prev ? prev->displaySize : glm::vec2(0, 0);
+  if (js.contains("display"))
+    f.displaySize = {js["display"][0], js["display"][1]};
+  f.mouseButtons = js.value("buttons", 0);
+  f.mouseWheel   = js.value("wheel", 0.f);
+  f.mouseWheelH  = js.value("wheelH", 0.f);
+  f.modifiers    = js.value("mods", 0);
+  if (js.contains("keys"))
+    f.keysDown = js["keys"].get<std::vector<int>>();
+  if (js.contains("chars"))
+    f.characters = js["chars"].get<std::vector<int>>();
+  return f;
+}
+
+InputFrame captureFrame(ImGuiIO const& io)
+{
+  InputFrame f;
+  f.deltaTime   = io.DeltaTime;
+  f.displaySize = {io.DisplaySize.x, io.DisplaySize.y};
+  f.mousePos    = {io.MousePos.x, io.MousePos.y};
+  for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); ++i)
+    if (io.MouseDown[i])
+      f.mouseButtons |= 1 << i;
+  f.mouseWheel  = io.MouseWheel;
+  f.mouseWheelH = io.MouseWheelH;
+  f.modifiers   = (io.KeyCtrl ? InputFrame::MOD_CTRL : 0) |
+                (io.KeyShift ? InputFrame::MOD_SHIFT : 0) |
+                (io.KeyAlt ? InputFrame::MOD_ALT : 0) | (io.KeySuper ? InputFrame::MOD_SUPER : 0);
+  for (int i = 0; i < IM_ARRAYSIZE(io.KeysDown); ++i)
+    if (io.KeysDown[i])
+      f.keysDown.push_back(i);
+  for (int i = 0; i < io.InputQueueCharacters.Size; ++i)
+    f.characters.push_back(io.InputQueueCharacters[i]);
+  return f;
+}
+
+// node ids and names depend on what happened before the recording, positions do not
+nlohmann::json fingerprint(Graph const& graph)
+{
+  std::vector<std::pair<float, float>> positions;
+  positions.reserve(graph.nodes().size());
+  for (auto const& n : graph.nodes())
+    positions.emplace_back(n.second.pos().x, n.second.pos().y);
+  std::sort(positions.begin(), positions.end());
+  nlohmann::json js = {{"nodes", graph.nodes().size()},
+                       {"links", graph.links().size()},
+                       {"positions", nlohmann::json::array()}};
+  for (auto const& p : positions)
+    js["positions"].push_back({p.first, p.second});
+  return js;
+}
+
+nlohmann::json captureInitialState(Graph const& graph)
+{
+  nlohmann::json state;
+  graph.save(state["graph"], "");
+  auto& views = state["views"] = nlohmann::json::array();
+  for (auto const* gv : graph.viewers()) {
+    views.push_back({
+        {"kind", int(gv->kind)},
+        {"canvasOffset", {gv->canvasOffset.x, gv->canvasOffset.y}},
+        {"canvasScale", gv->canvasScale},
+        {"selection", gv->nodeSelection},
+    });
+  }
+  size_t      iniSize = 0;
+  char const* ini     = ImGui::SaveIniSettingsToMemory(&iniSize);
+  state["imguiIni"]   = std::string(ini, iniSize);
+  return state;
+}
+
+} // namespace
+
+bool recording()
+{
+  return recorder().active;
+}
+
+void startRecording(Graph const& graph)
+{
+  auto& r   = recorder();
+  r         = Recorder();
+  r.graph   = &graph;
+  r.active  = true;
+  r.started = false;
+}
+
+void recordFrame()
+{
+  auto& r = recorder();
+  if (!r.active)
+    return;
+  if (!r.started) {
+    r.initial = captureInitialState(*r.graph);
+    r.started = true;
+  }
+  r.frames.push_back(captureFrame(ImGui::GetIO()));
+}
+
+void stopRecording()
+{
+  auto& r = recorder();
+  if (!r.active)
+    return;
+  r.active = false;
+  if (r.started)
+    r.final = fingerprint(*r.graph);
+  r.graph = nullptr;
+}
+
+size_t recordedFrames()
+{
+  return recorder().frames.size();
+}
+
+bool saveRecording(std::string const& path)
+{
+  auto const& r = recorder();
+  if (r.active || r.frames.empty())
+    return false;
+  nlohmann::json doc = {
+      {"version", FORMAT_VERSION},
+      {"initial", r.initial},
+      {"final", r.final},
+      {"frames", nlohmann::json::array()},
+  };
+  auto& frames = doc["frames"];
+  for (size_t i = 0; i < r.frames.size(); ++i)
+    frames.push_back(frameToJson(r.frames[i], i ? &r.frames[i - 1] : nullptr));
+
+  std::ofstream ofile(path, std::ios::binary);
+  if (!ofile)
+    return false;
+  ofile << doc.dump();
+  return !!ofile;
+}
+
+bool Replay::load(std::string const& path, std::string* error)
+{
+  auto const fail = [error](std::string const& msg) {
+    if (error)
+      *error = msg;
+    return false;
+  };
+  std::ifstream ifile(path, std::ios::binary);
+  if (!ifile)
+    return fail("cannot open \"" + path + "\"");
+  try {
+    auto const doc = nlohmann::json::parse(ifile);
+    if (doc.value("version", 0) != FORMAT_VERSION)
+      return fail("unsupported recording version");
+    initial_ = doc.at("initial");
+    final_   = doc.value("final", nlohmann::json());
+    frames_.clear();
+    for (auto const& f : doc.at("frames"))
+      frames_.push_back(frameFromJson(f, frames_.empty() ? nullptr : &frames_.back()));
+  } catch (std::exception const& e) {
+    return fail(e.what());
+  }
+  return true;
+}
+
+bool Replay::restore(Graph& graph) const
+{
+  if (initial_.is_null())
+    return false;
+  std::string const& ini = initial_.at("imguiIni");
+  ImGui::LoadIniSettingsFromMemory(ini.c_str(), ini.size());
+  if (!graph.load(initial_.at("graph"), ""))
+    spdlog::warn("replay: hook failed to load the initial graph");
+  graph.resetHistory();
+
+  auto const& views = initial_.at("views");
+  for (size_t i = 0; i < views.size(); ++i) {
+    auto const& vs = views[i];
+    if (i >= graph.viewers().size())
+      graph.addViewer(GraphView::Kind(vs.at("kind").get<int>()));
+    GraphView* gv     = graph.viewers()[i];
+    gv->canvasOffset  = {vs.at("canvasOffset")[0], vs.at("canvasOffset")[1]};
+    gv->canvasScale   = vs.at("canvasScale");
+    gv->nodeSelection = vs.at("selection").get<std::set<size_t>>();
+  }
+  return true;
+}
+
+void Replay::feed(ImGuiIO& io, int frame) const
+{
+  if (frame < 0 || frame >= frameCount())
+    return;
+  auto const& f  = frames_[frame];
+  io.DeltaTime   = f.deltaTime;
+  io.DisplaySize = ImVec2(f.displaySize.x, f.displaySize.y);
+  io.MousePos    = ImVec2(f.mousePos.x, f.mousePos.y);
+  for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); ++i)
+    io.MouseDown[i] = (f.mouseButtons >> i) & 1;
+  io.MouseWheel  = f.mouseWheel;
+  io.MouseWheelH = f.mouseWheelH;
+  io.KeyCtrl     = f.modifiers & InputFrame::MOD_CTRL;
+  io.KeyShift    = f.modifiers & InputFrame::MOD_SHIFT;
+  io.KeyAlt      = f.modifiers & InputFrame::MOD_ALT;
+  io.KeySuper    = f.modifiers & InputFrame::MOD_SUPER;
+  for (int i = 0; i < IM_ARRAYSIZE(io.KeysDown); ++i)
+    io.KeysDown[i] = false;
+  for (int key : f.keysDown)
+    if (key >= 0 && key < IM_ARRAYSIZE(io.KeysDown))
+      io.KeysDown[key] = true;
+  for (int c : f.characters)
+    io.AddInputCharacter(unsigned(c));
+}
+
+bool Replay::verify(Graph const& graph, std::string* mismatch) const
+{
+  if (final_.is_null())
+    return true; // recorded without final state
+  auto const actual = fingerprint(graph);
+  auto const report = [mismatch](std::string const& msg) {
+    if (mismatch)
+      *mismatch = msg;
+    return false;
+  };
+  for (char const* key : {"nodes", "links"})
+    if (actual[key] != final_[key])
+      return report(fmt::format("{} count {} differs from recorded {}",
+                                key,
+                                actual[key].get<size_t>(),
+                                final_[key].get<size_t>()));
+  auto const& expected = final_["positions"];
+  auto const& got      = actual["positions"];
+  for (size_t i = 0; i < expected.size(); ++i) {
+    float const dx = got[i][0].get<float>() - expected[i][0].get<float>();
+    float const dy = got[i][1].get<float>() - expected[i][1].get<float>();
+    if (std::abs(dx) > 1e-3f || std::abs(dy) > 1e-3f)
+      return report(fmt::format("node positions differ, e.g. ({}, {}) instead of ({}, {})",
+                                got[i][0].get<float>(),
+                                got[i][1].get<float>(),
+                                expected[i][0].get<float>(),
+                                expected[i][1].get<float>()));
+  }
+  return true;
+}
+
+} // namespace session
+} // namespace editorui
@@ -0,0 +1,76 @@
+#pragma once
+// records the ImGui input stream of an editing session and replays it frame by frame
+// a recording starts with the graph, view & window layout state it was started from,
+// so that replays, e.g. with the headless entry, walk through the same UI states
+
+#include "nodegraph.h"
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <vector>
+
+struct ImGuiIO;
+
+namespace editorui {
+namespace session {
+
+/// input of one frame, as the backend fed it into ImGuiIO
+struct InputFrame
+{
+  float            deltaTime     = 0;
+  glm::vec2        displaySize   = {0, 0};
+  glm::vec2        mousePos      = {0, 0};
+  int              mouseButtons  = 0; // bit i: io.MouseDown[i]
+  float            mouseWheel    = 0;
+  float            mouseWheelH   = 0;
+  int              modifiers     = 0; // MOD_* bits
+  std::vector<int> keysDown;          // indices into io.KeysDown
+  std::vector<int> characters;        // io.InputQueueCharacters
+
+  enum : int
+  {
+    MOD_CTRL  = 1,
+    MOD_SHIFT = 2,
+    MOD_ALT   = 4,
+    MOD_SUPER = 8,
+  };
+};
+
+/// recording is driven by the app loop, which calls recordFrame() once per frame,
+/// after ImGui::NewFrame() and before the UI is built
+bool   recording();
+void   startRecording(Graph const& graph); // state is captured by the next recordFrame()
+void   recordFrame();
+void   stopRecording(); // also captures the final graph state, for Replay::verify()
+size_t recordedFrames();
+
+/// writes the last recording as JSON, false if there is none or the file can not be written
+bool saveRecording(std::string const& path);
+
+class Replay
+{
+public:
+  bool load(std::string const& path, std::string* error = nullptr);
+
+  int       frameCount() const { return int(frames_.size()); }
+  glm::vec2 displaySize() const { return frames_.empty() ? glm::vec2(0, 0) : frames_[0].displaySize; }
+
+  /// restores window layout, graph and views; call once, before the first ImGui::NewFrame()
+  /// undo history is reset to the restored state
+  bool restore(Graph& graph) const;
+
+  /// feeds the input of given frame into io; call before ImGui::NewFrame()
+  void feed(ImGuiIO& io, int frame) const;
+
+  /// compares node count, link count & node positions with the end of the recording
+  bool verify(Graph const& graph, std::string* mismatch = nullptr) const;
+
+private:
+  nlohmann::json          initial_; // graph, views & window layout
+  nlohmann::json          final_;   // fingerprint at the end of the recording
+  std::vector<InputFrame> frames_;
+};
+
+} // namespace session
+} // namespace editorui
@@ -0,0 +1,386 @@
+#include "instrumentedhook.h"
+#include "profiler.h"
+
+namespace editorui {
+
+// phase names double as method names, skip the "hook/" prefix for the latter
+static char const* const PHASE_NAMES[InstrumentedHook::METHOD_COUNT] = {
+    "hook/onSave",
+    "hook/onLoad",
+    "hook/onPartialSave",
+    "hook/onPartialLoad",
+    "hook/createGraph",
+    "hook/createNode",
+    "hook/createNodes",
+    "hook/onNodeNameChanged",
+    "hook/onNodeColorChanged",
+    "hook/getNodeSize",
+    "hook/getNodeMinInputCount",
+    "hook/getNodeMaxInputCount",
+    "hook/getNodeOutputCount",
+    "hook/getPinDescription",
+    "hook/getIcon",
+    "hook/onNodeDraw",
+    "hook/onGraphDraw",
+    "hook/onNodeInspect",
+    "hook/onInspectNodeData",
+    "hook/onInspectGraphSummary",
+    "hook/onToolMenu",
+    "hook/onNodeSelected",
+    "hook/onNodeDeselected",
+    "hook/onClicked",
+    "hook/onNodeHovered",
+    "hook/onDoubleClicked",
+    "hook/onPinHovered",
+    "hook/onNodeMovedTo",
+    "hook/nodeCanBeDeleted",
+    "hook/beforeDeleteNode",
+    "hook/beforeDeleteGraph",
+    "hook/linkCanBeAttached",
+    "hook/onLinkAttached",
+    "hook/onLinkDetached",
+    "hook/nodeClassList",
+};
+static constexpr size_t PHASE_PREFIX = sizeof("hook/") - 1;
+
+// times one forwarded call, the calling phase is taken before our own scope opens
+class InstrumentedHook::Call
+{
+  InstrumentedHook& self_;
+  Method            method_;
+  int               operation_;
+  double            start_;
+  profiler::Scope   scope_;
+
+public:
+  Call(InstrumentedHook& self, Method method)
+      : self_(self)
+      , method_(method)
+      , operation_(profiler::currentPhase())
+      , start_(profiler::now())
+      , scope_(self.phases_[method])
+  {
+  }
+  ~Call()
+  {
+    double const ms = profiler::now() - start_;
+    scope_.end();
+    self_.record(method_, operation_, ms);
+  }
+};
+
+char const* InstrumentedHook::methodName(Method method)
+{
+  return method >= 0 && method < METHOD_COUNT ? PHASE_NAMES[method] + PHASE_PREFIX : "";
+}
+
+InstrumentedHook::InstrumentedHook(NodeGraphHook* inner)
+    : inner_(inner)
+    , byOperation_(new OperationTotals())
+{
+  assert(inner_);
+  for (int i = 0; i < METHOD_COUNT; ++i)
+    phases_[i] = profiler::phaseId(PHASE_NAMES[i]);
+}
+
+void InstrumentedHook::record(Method method, int operation, double ms)
+{
+  int64_t const ns = int64_t(ms * 1e6);
+  if (operation < -1 || operation >= profiler::MAX_PHASES)
+    operation = -1;
+  for (Totals* total : {&totals_[method], &(*byOperation_)[operation + 1][method]}) {
+    total->calls.fetch_add(1, std::memory_order_relaxed);
+    total->ns.fetch_add(ns, std::memory_order_relaxed);
+  }
+}
+
+std::vector<InstrumentedHook::MethodStats> InstrumentedHook::methodStats() const
+{
+  std::vector<MethodStats> result;
+  for (int i = 0; i < METHOD_COUNT; ++i) {
+    int64_t const calls = totals_[i].calls.load(std::memory_order_relaxed);
+    if (calls)
+      result.push_back(
+          {methodName(Method(i)), calls, totals_[i].ns.load(std::memory_order_relaxed) * 1e-6});
+  }
+  return result;
+}
+
+std::vector<InstrumentedHook::OperationStats> InstrumentedHook::operationStats() const
+{
+  std::vector<OperationStats> result;
+  for (int op = 0; op <= profiler::MAX_PHASES; ++op) {
+    for (int i = 0; i < METHOD_COUNT; ++i) {
+      auto const&   total = (*byOperation_)[op][i];
+      int64_t const calls = total.calls.load(std::memory_order_relaxed);
+      if (!calls)
+        continue;
+      char const* operation = profiler::phaseName(op - 1);
+      result.push_back({operation ? operation : "(none)",
+                        methodName(Method(i)),
+                        calls,
+                        total.ns.load(std::memory_order_relaxed) * 1e-6});
+    }
+  }
+  return result;
+}
+
+void InstrumentedHook::reset()
+{
+  auto const clear = [](MethodTotals& totals) {
+    for (auto& total : totals) {
+      total.calls.store(0, std::memory_order_relaxed);
+      total.ns.store(0, std::memory_order_relaxed);
+    }
+  };
+  clear(totals_);
+  for (auto& totals : *byOperation_)
+    clear(totals);
+}
+
+void InstrumentedHook::adoptNodes(Graph* host)
+{
+  for (auto& n : host->nodes())
+    if (n.second.hook() == inner_)
+      n.second.setHook(this);
+}
+
+bool InstrumentedHook::onSave(Graph const* host, nlohmann::json& jsobj, std::string const& path)
+{
+  Call call(*this, ON_SAVE);
+  return inner_->onSave(host, jsobj, path);
+}
+
+bool InstrumentedHook::onLoad(Graph* host, nlohmann::json const& jsobj, std::string const& path)
+{
+  bool succeed;
+  {
+    Call call(*this, ON_LOAD);
+    succeed = inner_->onLoad(host, jsobj, path);
+  }
+  // hooks usually hand themselves to the loaded nodes
+  adoptNodes(host);
+  return succeed;
+}
+
+bool InstrumentedHook::onPartialSave(Graph const*            host,
+                                     nlohmann::json&         jsobj,
+                                     std::set<size_t> const& nodeset)
+{
+  Call call(*this, ON_PARTIAL_SAVE);
+  return inner_->onPartialSave(host, jsobj, nodeset);
+}
+
+bool InstrumentedHook::onPartialLoad(Graph*                                    host,
+                                     nlohmann::json const&                     jsobj,
+                                     std::set<size_t> const&                   nodeset,
+                                     std::unordered_map<size_t, size_t> const& idmap)
+{
+  bool succeed;
+  {
+    Call call(*this, ON_PARTIAL_LOAD);
+    succeed = inner_->onPartialLoad(host, jsobj, nodeset, idmap);
+  }
+  adoptNodes(host);
+  return succeed;
+}
+
+void* InstrumentedHook::createGraph(Graph const* host)
+{
+  Call call(*this, CREATE_GRAPH);
+  return inner_->createGraph(host);
+}
+
+void* InstrumentedHook::createNode(Graph*             host,
+                                   std::string const& type,
+                                   std::string const& desiredName,
+                                   std::string&       acceptedName)
+{
+  Call call(*this, CREATE_NODE);
+  return inner_->createNode(host, type, desiredName, acceptedName);
+}
+
+void InstrumentedHook::createNodes(Graph*                          host,
+                                   std::vector<std::string> const& types,
+                                   std::vector<std::string> const& desiredNames,
+                                   std::vector<std::string>&       acceptedNames,
+                                   std::vector<void*>&             payloads)
+{
+  Call call(*this, CREATE_NODES);
+  inner_->createNodes(host, types, desiredNames, acceptedNames, payloads);
+}
+
+bool InstrumentedHook::onNodeNameChanged(Node const*        node,
+                                         std::string const& desiredName,
+                                         std::string&       acceptedName)
+{
+  Call call(*this, ON_NODE_NAME_CHANGED);
+  return inner_->onNodeNameChanged(node, desiredName, acceptedName);
+}
+
+void InstrumentedHook::onNodeColorChanged(Node const* node, glm::vec4 const& newcolor)
+{
+  Call call(*this, ON_NODE_COLOR_CHANGED);
+  inner_->onNodeColorChanged(node, newcolor);
+}
+
+glm::vec2 InstrumentedHook::getNodeSize(Node const* node)
+{
+  Call call(*this, GET_NODE_SIZE);
+  return inner_->getNodeSize(node);
+}
+
+int InstrumentedHook::getNodeMinInputCount(Node const* node)
+{
+  Call call(*this, GET_NODE_MIN_INPUT_COUNT);
+  return inner_->getNodeMinInputCount(node);
+}
+
+int InstrumentedHook::getNodeMaxInputCount(Node const* node)
+{
+  Call call(*this, GET_NODE_MAX_INPUT_COUNT);
+  return inner_->getNodeMaxInputCount(node);
+}
+
+int InstrumentedHook::getNodeOutputCount(Node const* node)
+{
+  Call call(*this, GET_NODE_OUTPUT_COUNT);
+  return inner_->getNodeOutputCount(node);
+}
+
+char const* InstrumentedHook::getPinDescription(Node const* node, NodePin const& pin)
+{
+  Call call(*this, GET_PIN_DESCRIPTION);
+  return inner_->getPinDescription(node, pin);
+}
+
+char const* InstrumentedHook::getIcon(Node const* node)
+{
+  Call call(*this, GET_ICON);
+  return inner_->getIcon(node);
+}
+
+void InstrumentedHook::onNodeDraw(Node const* node, GraphView const& gv)
+{
+  Call call(*this, ON_NODE_DRAW);
+  inner_->onNodeDraw(node, gv);
+}
+
+void InstrumentedHook::onGraphDraw(Graph const* host, GraphView const& gv)
+{
+  Call call(*this, ON_GRAPH_DRAW);
+  inner_->onGraphDraw(host, gv);
+}
+
+bool InstrumentedHook::onNodeInspect(Node* node, GraphView const& gv)
+{
+  Call call(*this, ON_NODE_INSPECT);
+  return inner_->onNodeInspect(node, gv);
+}
+
+bool InstrumentedHook::onInspectNodeData(Node* node, GraphView const& gv)
+{
+  Call call(*this, ON_INSPECT_NODE_DATA);
+  return inner_->onInspectNodeData(node, gv);
+}
+
+void InstrumentedHook::onInspectGraphSummary(Graph* graph, GraphView const& gv)
+{
+  Call call(*this, ON_INSPECT_GRAPH_SUMMARY);
+  inner_->onInspectGraphSummary(graph, gv);
+}
+
+void InstrumentedHook::onToolMenu(Graph* graph, GraphView const& gv)
+{
+  Call call(*this, ON_TOOL_MENU);
+  inner_->onToolMenu(graph, gv);
+}
+
+bool InstrumentedHook::onNodeSelected(Node const* node, GraphView const& gv)
+{
+  Call call(*this, ON_NODE_SELECTED);
+  return inner_->onNodeSelected(node, gv);
+}
+
+void InstrumentedHook::onNodeDeselected(Node const* node, GraphView const& gv)
+{
+  Call call(*this, ON_NODE_DESELECTED);
+  inner_->onNodeDeselected(node, gv);
+}
+
+bool InstrumentedHook::onClicked(Node const* node, int mouseButton)
+{
+  Call call(*this, ON_CLICKED);
+  return inner_->onClicked(node, mouseButton);
+}
+
+void InstrumentedHook::onNodeHovered(Node const* node)
+{
+  Call call(*this, ON_NODE_HOVERED);
+  inner_->onNodeHovered(node);
+}
+
+bool InstrumentedHook::onDoubleClicked(Node const* node, int mouseButton)
+{
+  Call call(*this, ON_DOUBLE_CLICKED);
+  return inner_->onDoubleClicked(node, mouseButton);
+}
+
+void InstrumentedHook::onPinHovered(Node const* node, NodePin const& pin)
+{
+  Call call(*this, ON_PIN_HOVERED);
+  inner_->onPinHovered(node, pin);
+}
+
+bool InstrumentedHook::onNodeMovedTo(Node* node, glm::vec2 const& pos)
+{
+  Call call(*this, ON_NODE_MOVED_TO);
+  return inner_->onNodeMovedTo(node, pos);
+}
+
+bool InstrumentedHook::nodeCanBeDeleted(Node* node)
+{
+  Call call(*this, NODE_CAN_BE_DELETED);
+  return inner_->nodeCanBeDeleted(node);
+}
+
+void InstrumentedHook::beforeDeleteNode(Node* node)
+{
+  Call call(*this, BEFORE_DELETE_NODE);
+  inner_->beforeDeleteNode(node);
+}
+
+void InstrumentedHook::beforeDeleteGraph(Graph* host)
+{
+  Call call(*this, BEFORE_DELETE_GRAPH);
+  inner_->beforeDeleteGraph(host);
+}
+
+bool InstrumentedHook::linkCanBeAttached(Node* source,
+                                         int   srcOutputPin,
+                                         Node* dest,
+                                         int   destInputPin)
+{
+  Call call(*this, LINK_CAN_BE_ATTACHED);
+  return inner_->linkCanBeAttached(source, srcOutputPin, dest, destInputPin);
+}
+
+void InstrumentedHook::onLinkAttached(Node* source, int srcOutputPin, Node* dest, int destInputPin)
+{
+  Call call(*this, ON_LINK_ATTACHED);
+  inner_->onLinkAttached(source, srcOutputPin, dest, destInputPin);
+}
+
+void InstrumentedHook::onLinkDetached(Node* source, int srcOutputPin, Node* dest, int destInputPin)
+{
+  Call call(*this, ON_LINK_DETACHED);
+  inner_->onLinkDetached(source, srcOutputPin, dest, destInputPin);
+}
+
+std::vector<std::string> InstrumentedHook::nodeClassList()
+{
+  Call call(*this, NODE_CLASS_LIST);
+  return inner_->nodeClassList();
+}
+
+} // namespace editorui
@@ -0,0 +1,162 @@
+#pragma once
+// call accounting for NodeGraphHook
+// no ImGui in here - the model and headless tools use it too
+
+#include "nodegraph.h"
+#include "profiler.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace editorui {
+
+/// InstrumentedHook - forwards every NodeGraphHook call to another hook,
+/// counting calls and accumulating time per method
+///
+/// each call is also timed as profiler phase "hook/<method>", so per-frame history shows up
+/// in the profiler, and is attributed to the profiler phase it was called from
+/// (e.g. "Graph::stash" or "drawGraph/nodes") for per-operation breakdowns
+///
+/// usually installed through Graph::setHookInstrumented()
+class InstrumentedHook : public NodeGraphHook
+{
+public:
+  enum Method : int
+  {
+    ON_SAVE,
+    ON_LOAD,
+    ON_PARTIAL_SAVE,
+    ON_PARTIAL_LOAD,
+    CREATE_GRAPH,
+    CREATE_NODE,
+    CREATE_NODES,
+    ON_NODE_NAME_CHANGED,
+    ON_NODE_COLOR_CHANGED,
+    GET_NODE_SIZE,
+    GET_NODE_MIN_INPUT_COUNT,
+    GET_NODE_MAX_INPUT_COUNT,
+    GET_NODE_OUTPUT_COUNT,
+    GET_PIN_DESCRIPTION,
+    GET_ICON,
+    ON_NODE_DRAW,
+    ON_GRAPH_DRAW,
+    ON_NODE_INSPECT,
+    ON_INSPECT_NODE_DATA,
+    ON_INSPECT_GRAPH_SUMMARY,
+    ON_TOOL_MENU,
+    ON_NODE_SELECTED,
+    ON_NODE_DESELECTED,
+    ON_CLICKED,
+    ON_NODE_HOVERED,
+    ON_DOUBLE_CLICKED,
+    ON_PIN_HOVERED,
+    ON_NODE_MOVED_TO,
+    NODE_CAN_BE_DELETED,
+    BEFORE_DELETE_NODE,
+    BEFORE_DELETE_GRAPH,
+    LINK_CAN_BE_ATTACHED,
+    ON_LINK_ATTACHED,
+    ON_LINK_DETACHED,
+    NODE_CLASS_LIST,
+    METHOD_COUNT
+  };
+
+  static char const* methodName(Method method);
+
+  struct MethodStats
+  {
+    char const* method  = "";
+    int64_t     calls   = 0;
+    double      totalMs = 0;
+  };
+
+  struct OperationStats
+  {
+    char const* operation = ""; // profiler phase the calls were made from
+    char const* method    = "";
+    int64_t     calls     = 0;
+    double      totalMs   = 0;
+  };
+
+  explicit InstrumentedHook(NodeGraphHook* inner);
+
+  NodeGraphHook* inner() const { return inner_; }
+
+  /// totals since construction or last reset(), methods never called are left out
+  std::vector<MethodStats>    methodStats() const;
+  std::vector<OperationStats> operationStats() const;
+  void                        reset();
+
+  bool onSave(Graph const* host, nlohmann::json& jsobj, std::string const& path) override;
+  bool onLoad(Graph* host, nlohmann::json const& jsobj, std::string const& path) override;
+  bool onPartialSave(Graph const*            host,
+                     nlohmann::json&         jsobj,
+                     std::set<size_t> const& nodeset) override;
+  bool onPartialLoad(Graph*                                    host,
+                     nlohmann::json const&                     jsobj,
+                     std::set<size_t> const&                   nodeset,
+                     std::unordered_map<size_t, size_t> const& idmap) override;
+  void* createGraph(Graph const* host) override;
+  void* createNode(Graph*             host,
+                   std::string const& type,
+                   std::string const& desiredName,
+                   std::string&       acceptedName) override;
+  void createNodes(Graph*                          host,
+                   std::vector<std::string> const& types,
+                   std::vector<std::string> const& desiredNames,
+                   std::vector<std::string>&       acceptedNames,
+                   std::vector<void*>&             payloads) override;
+  bool onNodeNameChanged(Node const*        node,
+                         std::string const& desiredName,
+                         std::string&       acceptedName) override;
+  void onNodeColorChanged(Node const* node, glm::vec4 const& newcolor) override;
+  glm::vec2 getNodeSize(Node const* node) override;
+  int getNodeMinInputCount(Node const* node) override;
+  int getNodeMaxInputCount(Node const* node) override;
+  int getNodeOutputCount(Node const* node) override;
+  char const* getPinDescription(Node const* node, NodePin const& pin) override;
+  char const* getIcon(Node const* node) override;
+  void onNodeDraw(Node const* node, GraphView const& gv) override;
+  void onGraphDraw(Graph const* host, GraphView const& gv) override;
+  bool onNodeInspect(Node* node, GraphView const& gv) override;
+  bool onInspectNodeData(Node* node, GraphView const& gv) override;
+  void onInspectGraphSummary(Graph* graph, GraphView const& gv) override;
+  void onToolMenu(Graph* graph, GraphView const& gv) override;
+  bool onNodeSelected(Node const* node, GraphView const& gv) override;
+  void onNodeDeselected(Node const* node, GraphView const& gv) override;
+  bool onClicked(Node const* node, int mouseButton) override;
+  void onNodeHovered(Node const* node) override;
+  bool onDoubleClicked(Node const* node, int mouseButton) override;
+  void onPinHovered(Node const* node, NodePin const& pin) override;
+  bool onNodeMovedTo(Node* node, glm::vec2 const& pos) override;
+  bool nodeCanBeDeleted(Node* node) override;
+  void beforeDeleteNode(Node* node) override;
+  void beforeDeleteGraph(Graph* host) override;
+  bool linkCanBeAttached(Node* source, int srcOutputPin, Node* dest, int destInputPin) override;
+  void onLinkAttached(Node* source, int srcOutputPin, Node* dest, int destInputPin) override;
+  void onLinkDetached(Node* source, int srcOutputPin, Node* dest, int destInputPin) override;
+  std::vector<std::string> nodeClassList() override;
+
+private:
+  struct Totals
+  {
+    std::atomic<int64_t> calls = {0};
+    std::atomic<int64_t> ns    = {0};
+  };
+  using MethodTotals    = std::array<Totals, METHOD_COUNT>;
+  using OperationTotals = std::array<MethodTotals, profiler::MAX_PHASES + 1>; // [phase + 1]
+  class Call;
+
+  // fixed slots, so that calls from any thread count without a lock or a lookup
+  NodeGraphHook*                   inner_;
+  std::array<int, METHOD_COUNT>    phases_; // profiler phase of each method
+  MethodTotals                     totals_;
+  std::unique_ptr<OperationTotals> byOperation_; // by profiler phase called from, -1: none
+
+  void record(Method method, int operation, double ms);
+  void adoptNodes(Graph* host); // re-points nodes the inner hook claimed to this
+};
+
+} // namespace editorui
@@ -0,0 +1,136 @@
+#include "latency.h"
+#include "profiler.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <array>
+
+namespace editorui {
+namespace latency {
+
+namespace {
+
+struct Ring
+{
+  std::array<float, HISTORY_SAMPLES> samples = {};
+  int                                head    = 0; // next slot to write
+  int                                size    = 0;
+
+  void push(float ms)
+  {
+    samples[head] = ms;
+    head          = (head + 1) % HISTORY_SAMPLES;
+    size          = std::min(size + 1, HISTORY_SAMPLES);
+  }
+
+  std::vector<float> ordered() const
+  {
+    std::vector<float> result(size);
+    for (int i = 0; i < size; ++i)
+      result[i] = samples[(head - size + i + HISTORY_SAMPLES) % HISTORY_SAMPLES];
+    return result;
+  }
+
+  Stats stats() const
+  {
+    Stats st;
+    auto  sorted = ordered();
+    if (sorted.empty())
+      return st;
+    st.samples = sorted.size();
+    st.lastMs  = sorted.back();
+    std::sort(sorted.begin(), sorted.end());
+    auto const at = [&sorted](double p) {
+      return sorted[std::min(sorted.size() - 1, size_t(p * (sorted.size() - 1) + 0.5))];
+    };
+    st.p50Ms = at(0.5);
+    st.p90Ms = at(0.9);
+    st.p99Ms = at(0.99);
+    st.maxMs = sorted.back();
+    return st;
+  }
+};
+
+// everything happens on the thread running the main loop
+struct State
+{
+  double pendingInputMs = -1; // earliest input not yet picked up by a frame
+  double frameInputMs   = -1; // input handled by the frame in flight
+  bool   rendered       = false;
+  Ring   toRender;
+  Ring   toPresent;
+};
+
+State& state()
+{
+  static State s;
+  return s;
+}
+
+} // namespace
+
+void inputReceived()
+{
+  inputReceived(profiler::now());
+}
+
+void inputReceived(double timestampMs)
+{
+  auto& s = state();
+  if (s.pendingInputMs < 0 || timestampMs < s.pendingInputMs)
+    s.pendingInputMs = timestampMs;
+  trace::instant("input");
+}
+
+void beginFrame()
+{
+  auto& s          = state();
+  s.frameInputMs   = s.pendingInputMs;
+  s.pendingInputMs = -1;
+  s.rendered       = false;
+}
+
+void frameRendered()
+{
+  auto& s = state();
+  if (s.frameInputMs < 0 || s.rendered)
+    return;
+  s.rendered = true;
+  s.toRender.push(float(profiler::now() - s.frameInputMs));
+}
+
+void framePresented()
+{
+  auto& s = state();
+  if (s.frameInputMs < 0)
+    return;
+  double const ms = profiler::now() - s.frameInputMs;
+  s.toPresent.push(float(ms));
+  trace::counter("input latency (us)", int64_t(ms * 1000.0));
+  s.frameInputMs = -1; // one sample per frame
+}
+
+Stats inputToRender()
+{
+  return state().toRender.stats();
+}
+
+Stats inputToPresent()
+{
+  return state().toPresent.stats();
+}
+
+std::vector<float> history()
+{
+  return state().toPresent.ordered();
+}
+
+void reset()
+{
+  auto& s     = state();
+  s.toRender  = Ring();
+  s.toPresent = Ring();
+}
+
+} // namespace latency
+} // namespace editorui
@@ -0,0 +1,46 @@
+#pragma once
+// input-to-display latency: how long after the backend received input its effect was shown
+// no ImGui in here - backends in entry/ call it from their main loops
+
+#include <cstddef>
+#include <vector>
+
+namespace editorui {
+namespace latency {
+
+/// backends call this for each input event (mouse, wheel, keys) as their loop receives it
+/// the earliest input since the last beginFrame() is what a frame's latency is measured from
+void inputReceived();
+void inputReceived(double timestampMs); // on profiler::now()'s clock
+
+/// app::update() calls this: input received so far is handled by this frame
+void beginFrame();
+
+/// backends call these after RenderDrawData and after swap / present of the main window
+void frameRendered();
+void framePresented();
+
+/// number of samples kept for the statistics below
+constexpr int HISTORY_SAMPLES = 512;
+
+struct Stats
+{
+  size_t samples = 0; // frames with input in the rolling window
+  float  lastMs  = 0;
+  float  p50Ms   = 0;
+  float  p90Ms   = 0;
+  float  p99Ms   = 0;
+  float  maxMs   = 0;
+};
+
+/// input received -> RenderDrawData done, and input received -> swap / present done
+Stats inputToRender();
+Stats inputToPresent();
+
+/// input -> present latency of the last samples, oldest first
+std::vector<float> history();
+
+void reset();
+
+} // namespace latency
+} // namespace editorui
@@ -0,0 +1,963 @@
+#include "layout.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace editorui {
+namespace layout {
+
+namespace {
+
+constexpr size_t VERTEX_GRAIN  = 2048;  // vertices per thread, fewer do not pay off
+constexpr float  DUMMY_WIDTH   = 8.f;   // room kept for a link passing a layer
+constexpr int    COORD_PASSES  = 8;     // of coordinate assignment, alternating down and up
+constexpr float  DUMMY_WEIGHT  = 8.f;   // long links are straightened before short ones
+constexpr float  LONELY_WEIGHT = 0.01f; // of vertices without neighbours on the swept side
+constexpr int    STALE_ROUNDS  = 3;     // rounds without fewer crossings before giving up
+
+// threads kept across parallel loops, force layouts run several loops per frame
+// loops are split in fixed chunks, so results do not depend on which thread ran what
+class WorkerPool
+{
+public:
+  explicit WorkerPool(unsigned threads) // including the calling thread
+  {
+    for (unsigned i = 1; i < threads; ++i)
+      workers_.emplace_back([this] { work(); });
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+  }
+
+  unsigned size() const { return unsigned(workers_.size()) + 1; }
+
+  /// runs fn(begin, end) over [0, n) in chunks of at least grain items, at most one per thread
+  template<class Fn>
+  void parallelFor(size_t n, size_t grain, Fn const& fn)
+  {
+    size_t const chunks = std::min<size_t>(size(), n / std::max<size_t>(grain, 1));
+    if (chunks <= 1) {
+      fn(size_t(0), n);
+      return;
+    }
+    size_t const chunk = (n + chunks - 1) / chunks;
+    run(chunks, [&fn, chunk, n](size_t c) { fn(c * chunk, std::min(n, (c + 1) * chunk)); });
+  }
+
+private:
+  std::vector<std::thread>           workers_;
+  std::mutex                         mutex_;
+  std::condition_variable            wake_, done_;
+  std::function<void(size_t)> const* job_        = nullptr;
+  size_t                             chunks_     = 0;
+  std::atomic<size_t>                next_       = {0};
+  size_t                             finished_   = 0; // chunks
+  unsigned                           busy_       = 0; // workers that joined the current job
+  uint64_t                           generation_ = 0;
+  bool                               quit_       = false;
+
+  size_t runChunks(std::function<void(size_t)> const& job, size_t chunks)
+  {
+    size_t done = 0;
+    for (size_t c; (c = next_.fetch_add(1)) < chunks; ++done)
+      job(c);
+    return done;
+  }
+
+  void run(size_t chunks, std::function<void(size_t)> const& job)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // a worker waking up late joins the previous job, which has nothing left for it,
+      // next_ must not be reset under it
+      done_.wait(lock, [this] { return busy_ == 0; });
+      job_      = &job;
+      chunks_   = chunks;
+      finished_ = 0;
+      next_.store(0);
+      ++generation_;
+    }
+    wake_.notify_all();
+    size_t const                 done = runChunks(job, chunks);
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_ += done;
+    done_.wait(lock, [this] { return finished_ == chunks_; });
+  }
+
+  void work()
+  {
+    uint64_t seen = 0;
+    for (;;) {
+      std::function<void(size_t)> const* job;
+      size_t                             chunks;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return quit_ || generation_ != seen; });
+        if (quit_)
+          return;
+        seen   = generation_;
+        job    = job_;
+        chunks = chunks_;
+        ++busy_;
+      }
+      size_t const done = runChunks(*job, chunks);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ += done;
+        --busy_;
+      }
+      done_.notify_all();
+    }
+  }
+};
+
+// a link between adjacent layers, part of a longer one if either end is a dummy
+// ports are x offsets of the pins from the centers of their vertices, 0 on dummies
+struct Segment
+{
+  uint32_t other;     // vertex in the adjacent layer
+  float    port;      // of this vertex
+  float    otherPort; // of the other vertex
+};
+
+// compressed adjacency: neighbours of v are items[start[v] .. start[v + 1])
+struct Adjacency
+{
+  std::vector<uint32_t> start;
+  std::vector<Segment>  items;
+};
+
+struct Layered
+{
+  size_t                             realCount = 0; // vertices below are nodes, dummies above
+  std::vector<int32_t>               layer;
+  std::vector<float>                 width;
+  std::vector<std::vector<uint32_t>> layers; // vertices of each layer, in order
+  std::vector<uint32_t>              pos;    // index of each vertex within its layer
+  Adjacency                          up, down;
+};
+
+struct Link
+{
+  uint32_t from, to;
+  float    fromPort, toPort;
+};
+
+Adjacency buildAdjacency(size_t vertices, std::vector<std::pair<uint32_t, Segment>> const& pairs)
+{
+  Adjacency adj;
+  adj.start.assign(vertices + 1, 0);
+  for (auto const& p : pairs)
+    ++adj.start[p.first + 1];
+  for (size_t v = 0; v < vertices; ++v)
+    adj.start[v + 1] += adj.start[v];
+  adj.items.resize(pairs.size());
+  std::vector<uint32_t> fill(adj.start.begin(), adj.start.end() - 1);
+  for (auto const& p : pairs)
+    adj.items[fill[p.first]++] = p.second;
+  return adj;
+}
+
+// breaks cycles by reversing links that close one in depth first order, returns the count
+// and the preorder of the vertices, a fair first order within layers
+size_t breakCycles(size_t n, std::vector<Link>& links, std::vector<uint32_t>& preorder)
+{
+  std::vector<uint32_t> start(n + 1, 0), out;
+  std::vector<uint32_t> indegree(n, 0);
+  for (auto const& l : links) {
+    ++start[l.from + 1];
+    ++indegree[l.to];
+  }
+  for (size_t v = 0; v < n; ++v)
+    start[v + 1] += start[v];
+  out.resize(links.size());
+  {
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (uint32_t i = 0; i < links.size(); ++i)
+      out[fill[links[i].from]++] = i;
+  }
+
+  enum : uint8_t
+  {
+    NEW,
+    OPEN,
+    DONE
+  };
+  std::vector<uint8_t>                         state(n, NEW);
+  std::vector<std::pair<uint32_t, uint32_t>>   stack; // vertex, next outgoing link
+  std::vector<uint8_t>                         reverse(links.size(), 0);
+  preorder.assign(n, 0);
+  uint32_t visited = 0;
+  auto     visit   = [&](uint32_t root) {
+    state[root]      = OPEN;
+    preorder[root]   = visited++;
+    stack.push_back({root, start[root]});
+    while (!stack.empty()) {
+      auto& [v, next] = stack.back();
+      if (next == start[v + 1]) {
+        state[v] = DONE;
+        stack.pop_back();
+        continue;
+      }
+      uint32_t const link = out[next++];
+      uint32_t const to   = links[link].to;
+      if (state[to] == OPEN) {
+        reverse[link] = 1;
+      } else if (state[to] == NEW) {
+        state[to]    = OPEN;
+        preorder[to] = visited++;
+        stack.push_back({to, start[to]});
+      }
+    }
+  };
+  for (uint32_t v = 0; v < n; ++v) // sources first, so that they end up on top
+    if (indegree[v] == 0 && state[v] == NEW)
+      visit(v);
+  for (uint32_t v = 0; v < n; ++v)
+    if (state[v] == NEW)
+      visit(v);
+
+  size_t reversed = 0;
+  for (size_t i = 0; i < links.size(); ++i) {
+    if (!reverse[i])
+      continue;
+    auto& l = links[i];
+    std::swap(l.from, l.to);
+    std::swap(l.fromPort, l.toPort);
+    ++reversed;
+  }
+  return reversed;
+}
+
+// longest path layering of the acyclic links, then sources are pulled down to just above
+// their highest successor
+std::vector<int32_t> assignLayers(size_t n, std::vector<Link> const& links)
+{
+  std::vector<uint32_t> start(n + 1, 0), out(links.size()), indegree(n, 0);
+  for (auto const& l : links) {
+    ++start[l.from + 1];
+    ++indegree[l.to];
+  }
+  for (size_t v = 0; v < n; ++v)
+    start[v + 1] += start[v];
+  {
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (auto const& l : links)
+      out[fill[l.from]++] = l.to;
+  }
+  std::vector<int32_t>  layer(n, 0);
+  std::vector<uint32_t> queue;
+  queue.reserve(n);
+  std::vector<uint32_t> pending = indegree;
+  for (uint32_t v = 0; v < n; ++v)
+    if (!indegree[v])
+      queue.push_back(v);
+  for (size_t i = 0; i < queue.size(); ++i) {
+    uint32_t const v = queue[i];
+    for (uint32_t k = start[v]; k < start[v + 1]; ++k) {
+      uint32_t const to = out[k];
+      layer[to]         = std::max(layer[to], layer[v] + 1);
+      if (--pending[to] == 0)
+        queue.push_back(to);
+    }
+  }
+  for (uint32_t v = 0; v < n; ++v) {
+    if (indegree[v] || start[v] == start[v + 1])
+      continue;
+    int32_t highest = INT32_MAX;
+    for (uint32_t k = start[v]; k < start[v + 1]; ++k)
+      highest = std::min(highest, layer[out[k]]);
+    layer[v] = highest - 1;
+  }
+  return layer;
+}
+
+// splits links spanning several layers at dummy vertices and sets up the first order
+void buildLayered(Layered&                     g,
+                  std::vector<Link> const&     links,
+                  std::vector<int32_t> const&  layer,
+                  std::vector<float> const&    widths,
+                  std::vector<uint32_t> const& preorder)
+{
+  size_t const n = widths.size();
+  g.realCount    = n;
+  g.layer        = layer;
+  g.width        = widths;
+  std::vector<float> key(preorder.begin(), preorder.end()); // first order within layers
+
+  std::vector<std::pair<uint32_t, Segment>> ups, downs;
+  ups.reserve(links.size());
+  downs.reserve(links.size());
+  for (auto const& l : links) {
+    uint32_t upper     = l.from;
+    float    upperPort = l.fromPort;
+    for (int32_t at = layer[l.from] + 1; at < layer[l.to]; ++at) {
+      uint32_t const dummy = uint32_t(g.layer.size());
+      g.layer.push_back(at);
+      g.width.push_back(DUMMY_WIDTH);
+      key.push_back(key[l.from]);
+      downs.push_back({upper, {dummy, upperPort, 0.f}});
+      ups.push_back({dummy, {upper, 0.f, upperPort}});
+      upper     = dummy;
+      upperPort = 0;
+    }
+    downs.push_back({upper, {l.to, upperPort, l.toPort}});
+    ups.push_back({l.to, {upper, l.toPort, upperPort}});
+  }
+  size_t const vertices = g.layer.size();
+  g.up                  = buildAdjacency(vertices, ups);
+  g.down                = buildAdjacency(vertices, downs);
+
+  int32_t layerCount = 0;
+  for (int32_t l : g.layer)
+    layerCount = std::max(layerCount, l + 1);
+  g.layers.assign(layerCount, {});
+  for (uint32_t v = 0; v < vertices; ++v)
+    g.layers[g.layer[v]].push_back(v);
+  g.pos.resize(vertices);
+  for (auto& vs : g.layers) {
+    std::stable_sort(
+        vs.begin(), vs.end(), [&](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+    for (uint32_t i = 0; i < vs.size(); ++i)
+      g.pos[vs[i]] = i;
+  }
+}
+
+// crossings between layer l and l + 1, counted as inversions with a Fenwick tree
+size_t countCrossings(Layered const& g, size_t l)
+{
+  thread_local std::vector<uint32_t> lower, tree;
+  lower.clear();
+  for (uint32_t v : g.layers[l]) {
+    size_t const first = lower.size();
+    for (uint32_t k = g.down.start[v]; k < g.down.start[v + 1]; ++k)
+      lower.push_back(g.pos[g.down.items[k].other]);
+    std::sort(lower.begin() + first, lower.end());
+  }
+  size_t const width = g.layers[l + 1].size();
+  tree.assign(width + 1, 0);
+  size_t crossings = 0, seen = 0;
+  for (uint32_t p : lower) {
+    // segments seen so far ending right of p cross this one
+    size_t atMost = 0;
+    for (size_t i = p + 1; i > 0; i -= i & (~i + 1))
+      atMost += tree[i];
+    crossings += seen - atMost;
+    for (size_t i = p + 1; i <= width; i += i & (~i + 1))
+      ++tree[i];
+    ++seen;
+  }
+  return crossings;
+}
+
+size_t countCrossings(Layered const& g, WorkerPool& pool)
+{
+  if (g.layers.size() < 2)
+    return 0;
+  size_t const        pairs = g.layers.size() - 1;
+  std::vector<size_t> perPair(pairs, 0);
+  size_t const        grain = std::max<size_t>(1, pairs * VERTEX_GRAIN / g.layer.size());
+  pool.parallelFor(pairs, grain, [&](size_t begin, size_t end) {
+    for (size_t l = begin; l < end; ++l)
+      perPair[l] = countCrossings(g, l);
+  });
+  size_t total = 0;
+  for (size_t c : perPair)
+    total += c;
+  return total;
+}
+
+enum Sides
+{
+  ABOVE = 1,
+  BELOW = 2,
+};
+
+// orders layer l by the barycenters of its neighbours on the given sides
+// pin offsets count as fractions of a rank, so that links leave pins in order
+void sortLayer(Layered& g, size_t l, int sides, std::vector<float>& key)
+{
+  auto& vs = g.layers[l];
+  for (uint32_t v : vs) {
+    float    sum   = 0;
+    uint32_t count = 0;
+    for (auto const* adj : {sides & ABOVE ? &g.up : nullptr, sides & BELOW ? &g.down : nullptr}) {
+      if (!adj)
+        continue;
+      for (uint32_t k = adj->start[v]; k < adj->start[v + 1]; ++k) {
+        auto const& s = adj->items[k];
+        sum += float(g.pos[s.other]) + s.otherPort / g.width[s.other];
+      }
+      count += adj->start[v + 1] - adj->start[v];
+    }
+    key[v] = count ? sum / float(count) : float(g.pos[v]); // without neighbours it stays
+  }
+  std::stable_sort(vs.begin(), vs.end(), [&](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+  for (uint32_t i = 0; i < vs.size(); ++i)
+    g.pos[vs[i]] = i;
+}
+
+void reduceCrossings(Layered& g, int sweeps, WorkerPool& pool, LayeredStats& stats)
+{
+  NG_PROFILE_SCOPE("layout::reduceCrossings");
+  std::vector<float> key(g.layer.size(), 0.f);
+  size_t             best      = countCrossings(g, pool);
+  auto               bestOrder = g.layers;
+  stats.crossingsBefore        = best;
+  int                stale     = 0;
+  size_t const       layers    = g.layers.size();
+  size_t const       grain     = std::max<size_t>(1, layers * VERTEX_GRAIN / g.layer.size());
+  for (int round = 0; round < sweeps && best > 0 && stale < STALE_ROUNDS; ++round) {
+    // a layer's barycenters only read the layers next to it, so all odd layers can be
+    // sorted at once, then all even ones; both sides count, which untangles more than
+    // sweeps down and up did in our tests, and comes out the same for any thread count
+    for (size_t parity : {1, 0}) {
+      pool.parallelFor((layers + 1 - parity) / 2, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          sortLayer(g, 2 * i + parity, ABOVE | BELOW, key);
+      });
+    }
+    size_t const crossings = countCrossings(g, pool);
+    if (crossings < best) {
+      best      = crossings;
+      bestOrder = g.layers;
+      stale     = 0;
+    } else {
+      ++stale;
+    }
+  }
+  g.layers = std::move(bestOrder);
+  for (auto const& vs : g.layers)
+    for (uint32_t i = 0; i < vs.size(); ++i)
+      g.pos[vs[i]] = i;
+  stats.crossings = best;
+}
+
+// x of each vertex: alternating down and up, vertices move to the median of where their
+// neighbours would have them, as close as the order and the gaps allow; that is a weighted
+// isotonic regression, solved by pooling adjacent violators
+std::vector<float> assignX(Layered const& g, float nodeGap)
+{
+  NG_PROFILE_SCOPE("layout::assignX");
+  std::vector<float> x(g.layer.size(), 0.f);
+  auto const         gap = [&](uint32_t a, uint32_t b) {
+    bool const real = a < g.realCount && b < g.realCount;
+    return (g.width[a] + g.width[b]) * 0.5f + (real ? nodeGap : nodeGap * 0.5f);
+  };
+  for (auto const& vs : g.layers)
+    for (size_t i = 1; i < vs.size(); ++i)
+      x[vs[i]] = x[vs[i - 1]] + gap(vs[i - 1], vs[i]);
+
+  struct Block
+  {
+    float  weight, sum; // of weight * target
+    size_t first;
+  };
+  std::vector<float> target, weight, offset, wanted;
+  std::vector<Block> blocks;
+  for (int pass = 0; pass < COORD_PASSES; ++pass) {
+    bool const down = pass % 2 == 0;
+    auto const& adj = down ? g.up : g.down;
+    for (size_t step = 1; step < g.layers.size(); ++step) {
+      auto const& vs = g.layers[down ? step : g.layers.size() - 1 - step];
+      size_t const w  = vs.size();
+      target.resize(w);
+      weight.resize(w);
+      offset.resize(w);
+      for (size_t i = 0; i < w; ++i) {
+        uint32_t const v = vs[i];
+        offset[i]        = i ? offset[i - 1] + gap(vs[i - 1], v) : 0.f;
+        wanted.clear();
+        for (uint32_t k = adj.start[v]; k < adj.start[v + 1]; ++k) {
+          auto const& s = adj.items[k];
+          wanted.push_back(x[s.other] + s.otherPort - s.port); // lines the pins up
+        }
+        if (wanted.empty()) {
+          target[i] = x[v];
+          weight[i] = LONELY_WEIGHT;
+        } else {
+          auto mid = wanted.begin() + wanted.size() / 2;
+          std::nth_element(wanted.begin(), mid, wanted.end());
+          target[i] = *mid;
+          weight[i] = v < g.realCount ? 1.f : DUMMY_WEIGHT;
+        }
+      }
+      // with y = x - offset the gaps turn into y being non-decreasing
+      blocks.clear();
+      for (size_t i = 0; i < w; ++i) {
+        Block b = {weight[i], weight[i] * (target[i] - offset[i]), i};
+        while (!blocks.empty() &&
+               blocks.back().sum / blocks.back().weight >= b.sum / b.weight) {
+          b.weight += blocks.back().weight;
+          b.sum += blocks.back().sum;
+          b.first = blocks.back().first;
+          blocks.pop_back();
+        }
+        blocks.push_back(b);
+      }
+      for (size_t bi = 0; bi < blocks.size(); ++bi) {
+        size_t const end = bi + 1 < blocks.size() ? blocks[bi + 1].first : w;
+        float const  y   = blocks[bi].sum / blocks[bi].weight;
+        for (size_t i = blocks[bi].first; i < end; ++i)
+          x[vs[i]] = y + offset[i];
+      }
+    }
+  }
+  return x;
+}
+
+} // namespace
+
+LayeredStats layered(Graph&                  graph,
+                     std::set<size_t> const* selection,
+                     LayeredOptions const&   options)
+{
+  NG_PROFILE_SCOPE("layout::layered");
+  double const start = profiler::now();
+  LayeredStats stats;
+  unsigned const threads =
+      options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+  // nodes to lay out, in their drawing order so that equal layouts come out the same
+  std::vector<size_t>                  ids;
+  std::unordered_map<size_t, uint32_t> index;
+  for (size_t id : graph.order()) {
+    if (selection && !selection->count(id))
+      continue;
+    index[id] = uint32_t(ids.size());
+    ids.push_back(id);
+  }
+  size_t const n = ids.size();
+  if (n == 0)
+    return stats;
+
+  std::vector<glm::vec2> sizes(n);
+  glm::vec2              boundsMin(INFINITY);
+  for (size_t i = 0; i < n; ++i) {
+    auto const& node = graph.noderef(ids[i]);
+    sizes[i]         = node.size();
+    boundsMin        = glm::min(boundsMin, node.pos() - sizes[i] * 0.5f);
+  }
+
+  std::vector<Link> links;
+  links.reserve(graph.links().size());
+  for (auto const& link : graph.links()) {
+    auto from = index.find(link.second.nodeIndex), to = index.find(link.first.nodeIndex);
+    if (from == index.end() || to == index.end() || from->second == to->second)
+      continue;
+    auto const& src = graph.noderef(link.second.nodeIndex);
+    auto const& dst = graph.noderef(link.first.nodeIndex);
+    links.push_back({from->second,
+                     to->second,
+                     src.outputPinPos(link.second.pinNumber).x - src.pos().x,
+                     dst.inputPinPos(link.first.pinNumber).x - dst.pos().x});
+  }
+
+  Layered g;
+  {
+    NG_PROFILE_SCOPE("layout::assignLayers");
+    std::vector<uint32_t> preorder;
+    stats.reversed = breakCycles(n, links, preorder);
+    auto const layer = assignLayers(n, links);
+    std::vector<float> widths(n);
+    for (size_t i = 0; i < n; ++i)
+      widths[i] = sizes[i].x;
+    buildLayered(g, links, layer, widths, preorder);
+  }
+  stats.layers  = g.layers.size();
+  stats.dummies = g.layer.size() - n;
+
+  WorkerPool pool(threads);
+  reduceCrossings(g, options.sweeps, pool, stats);
+  std::vector<float> const x = assignX(g, options.nodeGap);
+
+  // each layer is as tall as its tallest node, nodes are centered in it
+  std::vector<float> layerHeight(g.layers.size(), 0.f), layerY(g.layers.size(), 0.f);
+  for (size_t i = 0; i < n; ++i)
+    layerHeight[g.layer[i]] = std::max(layerHeight[g.layer[i]], sizes[i].y);
+  for (size_t l = 1; l < g.layers.size(); ++l)
+    layerY[l] = layerY[l - 1] + (layerHeight[l - 1] + layerHeight[l]) * 0.5f + options.layerGap;
+
+  // the laid out nodes begin where they began before
+  std::vector<glm::vec2> positions(n);
+  glm::vec2              newMin(INFINITY);
+  for (size_t i = 0; i < n; ++i) {
+    positions[i] = {x[i], layerY[g.layer[i]]};
+    newMin       = glm::min(newMin, positions[i] - sizes[i] * 0.5f);
+  }
+  for (auto& p : positions)
+    p += boundsMin - newMin;
+
+  graph.moveNodesTo(ids, positions);
+  graph.stash();
+  stats.ms = profiler::now() - start;
+  return stats;
+}
+
+namespace {
+
+constexpr uint32_t LEAF_SIZE      = 8;      // points per quadtree leaf, walked one by one
+constexpr int      MAX_DEPTH      = 24;     // cells this deep hold points on top of each other
+constexpr float    MIN_DISTANCE   = 4.f;    // closer nodes push as hard as at this distance
+constexpr float    VELOCITY_DECAY = 0.4f;   // of the velocity, lost each tick
+constexpr float    ALPHA_MIN      = 0.001f; // forces cool down from 1 to this over the ticks
+constexpr float    REST_SPEED     = 0.05f;  // settled once no node moves faster, per tick
+constexpr float    CHARGE_SIZE    = 128.f;  // width + height of a node pushing with charge 1
+constexpr size_t   FORCE_GRAIN    = 1024;   // nodes per thread
+
+struct Cell
+{
+  glm::vec2 corner;    // top left
+  glm::vec2 center;    // of mass
+  float     mass  = 0; // sum of the charges in it
+  float     size  = 0; // of its sides
+  uint32_t  child = 0; // first of four, 0 for leaves
+  uint32_t  begin = 0, end = 0; // points in it, in QuadTree::points
+};
+
+struct QuadTree
+{
+  std::vector<Cell>     cells;
+  std::vector<uint32_t> points; // node indices, each cell's points are consecutive
+};
+
+void subdivide(QuadTree&                     tree,
+               std::vector<glm::vec2> const& pos,
+               std::vector<float> const&     charge,
+               uint32_t                      cell,
+               glm::vec2                     corner,
+               float                         size,
+               uint32_t                      begin,
+               uint32_t                      end,
+               int                           depth)
+{
+  tree.cells[cell].corner = corner;
+  tree.cells[cell].size   = size;
+  tree.cells[cell].begin  = begin;
+  tree.cells[cell].end    = end;
+  if (end - begin > LEAF_SIZE && depth < MAX_DEPTH) {
+    glm::vec2 const mid    = corner + glm::vec2(size * 0.5f);
+    auto* const     points = tree.points.data();
+    auto const      above  = [&](uint32_t i) { return pos[i].y < mid.y; };
+    auto const      left   = [&](uint32_t i) { return pos[i].x < mid.x; };
+    uint32_t const  y     = uint32_t(std::partition(points + begin, points + end, above) - points);
+    uint32_t const  x0    = uint32_t(std::partition(points + begin, points + y, left) - points);
+    uint32_t const  x1    = uint32_t(std::partition(points + y, points + end, left) - points);
+    uint32_t const  child = uint32_t(tree.cells.size());
+    tree.cells.resize(child + 4);
+    tree.cells[cell].child = child;
+
+    float const    half     = size * 0.5f;
+    uint32_t const bounds[] = {begin, x0, y, x1, end};
+    for (uint32_t q = 0; q < 4; ++q) {
+      glm::vec2 const at = corner + glm::vec2(q % 2 ? half : 0.f, q / 2 ? half : 0.f);
+      subdivide(tree, pos, charge, child + q, at, half, bounds[q], bounds[q + 1], depth + 1);
+    }
+  }
+
+  Cell&     c = tree.cells[cell];
+  glm::vec2 weighted(0.f);
+  c.mass = 0;
+  if (c.child) {
+    for (uint32_t q = 0; q < 4; ++q) {
+      weighted += tree.cells[c.child + q].center * tree.cells[c.child + q].mass;
+      c.mass += tree.cells[c.child + q].mass;
+    }
+  } else {
+    for (uint32_t k = begin; k < end; ++k) {
+      weighted += pos[tree.points[k]] * charge[tree.points[k]];
+      c.mass += charge[tree.points[k]];
+    }
+  }
+  c.center = c.mass > 0 ? weighted / c.mass : corner + glm::vec2(size * 0.5f);
+}
+
+void buildQuadTree(QuadTree&                     tree,
+                   std::vector<glm::vec2> const& pos,
+                   std::vector<float> const&     charge)
+{
+  NG_PROFILE_SCOPE("layout::buildQuadTree");
+  uint32_t const n = uint32_t(pos.size());
+  tree.points.resize(n);
+  for (uint32_t i = 0; i < n; ++i)
+    tree.points[i] = i;
+  glm::vec2 lo(INFINITY), hi(-INFINITY);
+  for (auto const& p : pos) {
+    lo = glm::min(lo, p);
+    hi = glm::max(hi, p);
+  }
+  tree.cells.clear();
+  tree.cells.reserve(n / 2 + 1);
+  tree.cells.emplace_back();
+  subdivide(tree, pos, charge, 0, lo, std::max(hi.x - lo.x, hi.y - lo.y) + 1.f, 0, n, 0);
+}
+
+// a link as seen from one of its nodes
+struct Spring
+{
+  uint32_t other;
+  float    strength; // of the pull, the less the more links either node has
+  float    share;    // of the correction this node makes, the other makes the rest
+  bool     below;    // whether the other node holds the input, i.e. belongs below this one
+};
+
+} // namespace
+
+struct ForceLayout::State
+{
+  ForceOptions           options;
+  std::vector<size_t>    ids;
+  std::vector<glm::vec2> pos, vel, dv;
+  std::vector<glm::vec2> applied; // positions the graph had or was given at the last step
+  std::vector<float>     charge;
+  std::vector<uint8_t>   pinned;
+  std::vector<uint32_t>  springStart; // springs of node i: springs[springStart[i] ..]
+  std::vector<Spring>    springs;
+  glm::vec2              center;
+  float                  alpha      = 1.f;
+  float                  alphaDecay = 0.f;
+  size_t                 ticks      = 0;
+  QuadTree               tree;
+  WorkerPool             pool;
+
+  explicit State(unsigned threads) : pool(threads) {}
+
+  void tick()
+  {
+    NG_PROFILE_SCOPE("layout::forceTick");
+    alpha += -alpha * alphaDecay;
+    ++ticks;
+    buildQuadTree(tree, pos, charge);
+
+    float const theta2 = options.theta * options.theta;
+    float const reach2 = options.reach * options.reach;
+    pool.parallelFor(pos.size(), FORCE_GRAIN, [&](size_t begin, size_t end) {
+      uint32_t stack[4 * MAX_DEPTH + 4];
+      for (size_t k = begin; k < end; ++k) {
+        uint32_t const  i = tree.points[k]; // in tree order, neighbours walk the same cells
+        glm::vec2 const p = pos[i];
+        glm::vec2       f(0.f);
+        // pushed away from every node, cells far enough count as a whole
+        auto const push = [&](glm::vec2 d, float mass) {
+          float dist2 = glm::dot(d, d);
+          if (dist2 > reach2)
+            return;
+          if (dist2 < MIN_DISTANCE * MIN_DISTANCE)
+            dist2 = MIN_DISTANCE * MIN_DISTANCE;
+          f -= d * (options.repulsion * mass / dist2);
+        };
+        int top      = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+          Cell const& c = tree.cells[stack[--top]];
+          if (c.mass == 0)
+            continue;
+          glm::vec2 const outside =
+              glm::max(glm::max(c.corner - p, p - c.corner - glm::vec2(c.size)), glm::vec2(0.f));
+          if (glm::dot(outside, outside) > reach2)
+            continue;
+          glm::vec2 const d = c.center - p;
+          if (c.child && c.size * c.size < theta2 * glm::dot(d, d)) {
+            push(d, c.mass);
+          } else if (c.child) {
+            for (uint32_t q = 0; q < 4; ++q)
+              stack[top++] = c.child + q;
+          } else {
+            for (uint32_t m = c.begin; m < c.end; ++m) {
+              uint32_t const j = tree.points[m];
+              if (j == i)
+                continue;
+              glm::vec2 dj = pos[j] - p;
+              if (dj == glm::vec2(0.f)) // on top of each other, part them the same way each tick
+                dj = glm::vec2(j > i ? 1.f : -1.f, j > i ? 0.5f : -0.5f);
+              push(dj, charge[j]);
+            }
+          }
+        }
+
+        for (uint32_t m = springStart[i]; m < springStart[i + 1]; ++m) {
+          Spring const&   s   = springs[m];
+          glm::vec2 const d   = pos[s.other] - p;
+          float const     len = std::max(glm::length(d), MIN_DISTANCE);
+          f += d * ((len - options.linkLength) / len * s.strength * s.share);
+          float const gap = options.linkLength - (s.below ? d.y : -d.y);
+          if (gap > 0)
+            f.y += (s.below ? -gap : gap) * options.flow * s.share;
+        }
+        glm::vec2 const home = center - p; // as strong at any distance, so large graphs keep
+        float const     away = glm::length(home); // their shape
+        if (away > options.linkLength)
+          f += home * (options.gravity / away);
+        dv[i] = f * alpha;
+      }
+    });
+
+    pool.parallelFor(pos.size(), FORCE_GRAIN, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        if (pinned[i]) {
+          vel[i] = glm::vec2(0.f);
+          continue;
+        }
+        vel[i] = (vel[i] + dv[i]) * (1.f - VELOCITY_DECAY);
+        pos[i] += vel[i];
+      }
+    });
+
+    float fastest = 0;
+    for (auto const& v : vel)
+      fastest = std::max(fastest, glm::dot(v, v));
+    if (fastest < REST_SPEED * REST_SPEED)
+      alpha = 0;
+  }
+};
+
+ForceLayout::ForceLayout(Graph const&            graph,
+                         std::set<size_t> const* pinned,
+                         ForceOptions const&     options)
+{
+  unsigned const threads =
+      options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  state_         = std::make_unique<State>(threads);
+  State& s       = *state_;
+  s.options      = options;
+  s.ids          = graph.order();
+  s.alphaDecay   = 1.f - std::pow(ALPHA_MIN, 1.f / float(std::max(options.ticks, 1)));
+  size_t const n = s.ids.size();
+
+  std::unordered_map<size_t, uint32_t> index;
+  s.pos.resize(n);
+  s.charge.resize(n);
+  s.pinned.assign(n, 0);
+  s.center = glm::vec2(0.f);
+  for (uint32_t i = 0; i < n; ++i) {
+    auto const& node = graph.noderef(s.ids[i]);
+    index[s.ids[i]]  = i;
+    s.pos[i]         = node.pos();
+    s.charge[i]      = std::max(1.f, (node.size().x + node.size().y) / CHARGE_SIZE);
+    s.pinned[i]      = pinned && pinned->count(s.ids[i]);
+    s.center += node.pos() / float(n);
+  }
+  s.applied = s.pos;
+  s.vel.assign(n, glm::vec2(0.f));
+  s.dv.resize(n);
+
+  std::vector<std::pair<uint32_t, uint32_t>> links; // output node, input node
+  std::vector<uint32_t>                      degree(n, 0);
+  for (auto const& link : graph.links()) {
+    uint32_t const from = index.at(link.second.nodeIndex), to = index.at(link.first.nodeIndex);
+    if (from == to)
+      continue;
+    links.emplace_back(from, to);
+    ++degree[from];
+    ++degree[to];
+  }
+  s.springStart.assign(n + 1, 0);
+  for (uint32_t v = 0; v < n; ++v)
+    s.springStart[v + 1] = s.springStart[v] + degree[v];
+  s.springs.resize(links.size() * 2);
+  std::vector<uint32_t> fill(s.springStart.begin(), s.springStart.end() - 1);
+  for (auto const& [from, to] : links) {
+    // like d3-force: nodes with many links pull weaker, and give way less
+    float const strength = 1.f / float(std::min(degree[from], degree[to]));
+    float const total    = float(degree[from] + degree[to]);
+    s.springs[fill[from]++] = {to, strength, float(degree[to]) / total, true};
+    s.springs[fill[to]++]   = {from, strength, float(degree[from]) / total, false};
+  }
+}
+
+ForceLayout::~ForceLayout() = default;
+
+void ForceLayout::pin(std::set<size_t> const& ids, bool pinned)
+{
+  for (size_t i = 0; i < state_->ids.size(); ++i)
+    if (ids.count(state_->ids[i]))
+      state_->pinned[i] = pinned;
+}
+
+bool ForceLayout::isPinned(size_t id) const
+{
+  auto itr = std::find(state_->ids.begin(), state_->ids.end(), id);
+  return itr != state_->ids.end() && state_->pinned[itr - state_->ids.begin()];
+}
+
+bool ForceLayout::step(Graph& graph, double budgetMs)
+{
+  State& s = *state_;
+  if (settled() || graph.nodes().size() != s.ids.size())
+    return false;
+  for (size_t i = 0; i < s.ids.size(); ++i) {
+    auto itr = graph.nodes().find(s.ids[i]);
+    if (itr == graph.nodes().end())
+      return false;
+    if (itr->second.pos() != s.applied[i]) { // dragged, or undone
+      s.pos[i] = s.applied[i] = itr->second.pos();
+      s.vel[i] = glm::vec2(0.f);
+    }
+  }
+  double const start = profiler::now();
+  do {
+    s.tick();
+  } while (!settled() && profiler::now() - start < budgetMs);
+  apply(graph);
+  return !settled();
+}
+
+void ForceLayout::settle()
+{
+  while (!settled())
+    state_->tick();
+}
+
+void ForceLayout::apply(Graph& graph)
+{
+  State&                 s = *state_;
+  std::vector<size_t>    ids;
+  std::vector<glm::vec2> positions;
+  for (size_t i = 0; i < s.ids.size(); ++i) {
+    if (s.pos[i] == s.applied[i])
+      continue;
+    ids.push_back(s.ids[i]);
+    positions.push_back(s.pos[i]);
+    s.applied[i] = s.pos[i];
+  }
+  if (!ids.empty())
+    graph.moveNodesTo(ids, positions);
+}
+
+bool ForceLayout::settled() const
+{
+  return state_->alpha < ALPHA_MIN || state_->ids.empty();
+}
+
+size_t ForceLayout::ticks() const
+{
+  return state_->ticks;
+}
+
+size_t force(Graph& graph, std::set<size_t> const* pinned, ForceOptions const& options)
+{
+  NG_PROFILE_SCOPE("layout::force");
+  ForceLayout layout(graph, pinned, options);
+  layout.settle();
+  layout.apply(graph);
+  graph.stash();
+  return layout.ticks();
+}
+
+} // namespace layout
+} // namespace editorui
@@ -0,0 +1,92 @@
+#pragma once
+// automatic node layouts, top to bottom to match the pins: inputs above, outputs below
+// no ImGui in here - the model and headless tools use it too
+
+#include "nodegraph.h"
+
+#include <memory>
+#include <set>
+
+namespace editorui {
+namespace layout {
+
+struct LayeredOptions
+{
+  float    layerGap = 48.f; // between the bottom of a layer and the top of the next
+  float    nodeGap  = 24.f; // between neighbours in a layer
+  int      sweeps   = 12;   // crossing reduction rounds, each sorts odd, then even layers
+  unsigned threads  = 0;    // for crossing reduction, 0: one per core
+};
+
+struct LayeredStats
+{
+  size_t layers          = 0;
+  size_t dummies         = 0; // points where links pass a layer, kept free of nodes
+  size_t reversed        = 0; // links pointing up, to break cycles
+  size_t crossingsBefore = 0; // crossings of the initial order
+  size_t crossings       = 0;
+  double ms              = 0;
+};
+
+/// layered (Sugiyama) layout: breaks cycles, assigns layers with sources on top, orders the
+/// nodes within layers to reduce crossings, then places them so that links run straight
+/// with a selection, only the selected nodes are laid out, among themselves, and stay
+/// where their bounds began; everything moves in one edit, recorded as one undo entry
+LayeredStats layered(Graph&                  graph,
+                     std::set<size_t> const* selection = nullptr,
+                     LayeredOptions const&   options   = {});
+
+struct ForceOptions
+{
+  float    linkLength = 160.f;  // rest length of links, between node centers
+  float    repulsion  = 1200.f; // between each pair of nodes, falls off with distance
+  float    reach      = 800.f;  // nodes further apart do not push each other
+  float    flow       = 0.3f;   // pulls inputs below their outputs, so links point down
+  float    gravity    = 1.f;    // pull towards the center the nodes began around
+  float    theta      = 0.8f;   // Barnes-Hut: cells smaller than theta * distance act as one
+  int      ticks      = 300;    // until settled, forces cool down over them
+  unsigned threads    = 0;      // 0: one per core
+};
+
+/// force-directed layout, for graphs that are not layered: links pull like springs, all nodes
+/// push each other apart, approximated through a quadtree (Barnes-Hut) to O(n log n) a tick
+/// pinned nodes stay where they are, and still pull and push the others
+/// keep one around to animate the layout, call step() each frame
+class ForceLayout
+{
+public:
+  /// starts from the current positions of the nodes of graph
+  ForceLayout(Graph const&            graph,
+              std::set<size_t> const* pinned  = nullptr,
+              ForceOptions const&     options = {});
+  ~ForceLayout();
+
+  void pin(std::set<size_t> const& ids, bool pinned);
+  bool isPinned(size_t id) const;
+
+  /// runs ticks for up to budgetMs (at least one) and moves the nodes of graph there
+  /// nodes moved by someone else since the last step restart from where they were put
+  /// returns false once settled, and without moving any when nodes were added or removed
+  /// the moves are not stashed, that is up to the caller once done
+  bool step(Graph& graph, double budgetMs);
+
+  /// runs the remaining ticks
+  void settle();
+  /// moves the nodes of graph to the current positions
+  void apply(Graph& graph);
+
+  bool   settled() const;
+  size_t ticks() const;
+
+private:
+  struct State;
+  std::unique_ptr<State> state_;
+};
+
+/// settles a ForceLayout in one go, recorded as one undo entry, returns the ticks it took
+size_t force(Graph&                  graph,
+             std::set<size_t> const* pinned  = nullptr,
+             ForceOptions const&     options = {});
+
+} // namespace layout
+} // namespace editorui
@@ -0,0 +1,240 @@
+#include "linkrouter.h"
+#include "profiler.h"
+
+#include <queue>
+
+namespace editorui {
+namespace linkrouter {
+
+namespace {
+
+constexpr float  SEARCH_PAD = 128.f;   // around the pins, room to pass their own nodes
+constexpr float  BEND_COST  = 24.f;    // in canvas units of length, a bend is worth that much
+constexpr size_t MAX_GRID   = 1 << 16; // grid points searched, larger areas are not routed
+
+enum Dir : uint8_t
+{
+  RIGHT,
+  LEFT,
+  DOWN,
+  UP
+};
+
+enum Blocked : uint8_t
+{
+  POINT_BLOCKED = 1, // inside an obstacle
+  RIGHT_BLOCKED = 2, // the edge to the next point on x crosses an obstacle
+  DOWN_BLOCKED  = 4, // the edge to the next point on y crosses an obstacle
+};
+
+struct Scratch
+{
+  std::vector<Rect>     rects;
+  std::vector<float>    xs, ys;
+  std::vector<uint8_t>  blocked;
+  std::vector<float>    cost;   // per grid point and direction of arrival
+  std::vector<int32_t>  parent; // state arrived from, -1 at the start
+  std::vector<uint32_t> stamp;  // cost and parent are valid where stamp == round
+  uint32_t              round = 0;
+};
+
+void uniqueSorted(std::vector<float>& values)
+{
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+size_t indexOf(std::vector<float> const& values, float v)
+{
+  return std::lower_bound(values.begin(), values.end(), v) - values.begin();
+}
+
+void dropCollinear(std::vector<glm::vec2>& path)
+{
+  size_t n = 0;
+  for (size_t i = 0; i < path.size(); ++i) {
+    if (n >= 2) {
+      glm::vec2 const a = path[n - 2], b = path[n - 1], c = path[i];
+      if ((a.x == b.x && b.x == c.x) || (a.y == b.y && b.y == c.y)) {
+        path[n - 1] = c;
+        continue;
+      }
+    }
+    path[n++] = path[i];
+  }
+  path.resize(n);
+}
+
+} // namespace
+
+Rect searchArea(glm::vec2 const& start, glm::vec2 const& end)
+{
+  return {glm::min(start, end) - glm::vec2(SEARCH_PAD),
+          glm::max(start, end) + glm::vec2(SEARCH_PAD)};
+}
+
+std::vector<glm::vec2> route(glm::vec2 const&         start,
+                             glm::vec2 const&         end,
+                             std::vector<Rect> const& obstacles)
+{
+  NG_PROFILE_SCOPE("linkrouter::route");
+  static thread_local Scratch s; // routes run on the UI thread and the link path worker
+
+  if (obstacles.size() > MAX_OBSTACLES)
+    return {};
+
+  glm::vec2 const from = start + glm::vec2(0, EXTEND);
+  glm::vec2 const to   = end - glm::vec2(0, EXTEND);
+  Rect const      area = searchArea(start, end);
+
+  // obstacles grown by the margin and clipped to the area, except those the stubs end in,
+  // e.g. when nodes overlap
+  s.rects.clear();
+  for (auto const& obstacle : obstacles) {
+    Rect r = {obstacle.min - glm::vec2(MARGIN), obstacle.max + glm::vec2(MARGIN)};
+    if (!r.intersects(area) || r.contains(from) || r.contains(to))
+      continue;
+    r.min = glm::max(r.min, area.min);
+    r.max = glm::min(r.max, area.max);
+    s.rects.push_back(r);
+  }
+
+  // the grid: lines through the stubs, halfway between them, and along every obstacle border
+  s.xs = {area.min.x, area.max.x, from.x, to.x, (from.x + to.x) * 0.5f};
+  s.ys = {area.min.y, area.max.y, from.y, to.y, (from.y + to.y) * 0.5f};
+  for (auto const& r : s.rects) {
+    s.xs.push_back(r.min.x);
+    s.xs.push_back(r.max.x);
+    s.ys.push_back(r.min.y);
+    s.ys.push_back(r.max.y);
+  }
+  uniqueSorted(s.xs);
+  uniqueSorted(s.ys);
+  size_t const w = s.xs.size(), h = s.ys.size();
+  if (w * h > MAX_GRID)
+    return {};
+
+  // obstacle borders are grid lines, so an edge crosses an obstacle iff its middle is inside
+  s.blocked.assign(w * h, 0);
+  for (auto const& r : s.rects) {
+    size_t const x0 = indexOf(s.xs, r.min.x), x1 = indexOf(s.xs, r.max.x);
+    size_t const y0 = indexOf(s.ys, r.min.y), y1 = indexOf(s.ys, r.max.y);
+    for (size_t y = y0; y <= y1; ++y) {
+      for (size_t x = x0; x <= x1; ++x) {
+        bool const insideX = x > x0 && x < x1, insideY = y > y0 && y < y1;
+        uint8_t&   b       = s.blocked[y * w + x];
+        if (insideX && insideY)
+          b |= POINT_BLOCKED;
+        if (insideY && x < x1)
+          b |= RIGHT_BLOCKED;
+        if (insideX && y < y1)
+          b |= DOWN_BLOCKED;
+      }
+    }
+  }
+
+  // A* over (grid point, direction of arrival), bends cost extra
+  size_t const states = w * h * 4;
+  if (s.stamp.size() < states) {
+    s.stamp.resize(states, 0);
+    s.cost.resize(states);
+    s.parent.resize(states);
+  }
+  if (++s.round == 0) { // wrapped around, stamps of 2^32 routes ago would look valid
+    std::fill(s.stamp.begin(), s.stamp.end(), 0);
+    s.round = 1;
+  }
+
+  size_t const goalX = indexOf(s.xs, to.x), goalY = indexOf(s.ys, to.y);
+  // off both axes of the goal, at least one bend is left
+  auto const heuristic = [&](size_t x, size_t y) {
+    return std::abs(s.xs[x] - to.x) + std::abs(s.ys[y] - to.y) +
+           (x != goalX && y != goalY ? BEND_COST : 0.f);
+  };
+  using Open = std::pair<float, int32_t>; // f, state
+  std::priority_queue<Open, std::vector<Open>, std::greater<Open>> open;
+
+  size_t const  startX = indexOf(s.xs, from.x), startY = indexOf(s.ys, from.y);
+  int32_t const first  = int32_t((startY * w + startX) * 4 + DOWN); // leaving the output pin
+  s.stamp[first]       = s.round;
+  s.cost[first]        = 0;
+  s.parent[first]      = -1;
+  open.push({heuristic(startX, startY), first});
+
+  float   best     = INFINITY;
+  int32_t bestGoal = -1;
+  while (!open.empty()) {
+    auto const [f, state] = open.top();
+    open.pop();
+    if (f >= best)
+      break;
+    float const g = s.cost[state];
+    if (f > g + heuristic((state / 4) % w, (state / 4) / w))
+      continue; // outdated entry
+    size_t const point = state / 4, x = point % w, y = point / w;
+    Dir const    dir   = Dir(state % 4);
+    if (x == goalX && y == goalY) {
+      float const total = g + (dir == DOWN ? 0 : BEND_COST); // entering the input pin
+      if (total < best) {
+        best     = total;
+        bestGoal = state;
+      }
+      continue;
+    }
+    for (int d = RIGHT; d <= UP; ++d) {
+      if ((dir ^ 1) == d) // no turning back
+        continue;
+      size_t nx = x, ny = y;
+      switch (d) {
+      case RIGHT:
+        if (x + 1 >= w || (s.blocked[point] & RIGHT_BLOCKED))
+          continue;
+        ++nx;
+        break;
+      case LEFT:
+        if (x == 0 || (s.blocked[point - 1] & RIGHT_BLOCKED))
+          continue;
+        --nx;
+        break;
+      case DOWN:
+        if (y + 1 >= h || (s.blocked[point] & DOWN_BLOCKED))
+          continue;
+        ++ny;
+        break;
+      case UP:
+        if (y == 0 || (s.blocked[point - w] & DOWN_BLOCKED))
+          continue;
+        --ny;
+        break;
+      }
+      size_t const next = ny * w + nx;
+      if (s.blocked[next] & POINT_BLOCKED)
+        continue;
+      float const   length  = std::abs(s.xs[nx] - s.xs[x]) + std::abs(s.ys[ny] - s.ys[y]);
+      float const   cost    = g + length + (d == dir ? 0 : BEND_COST);
+      int32_t const reached = int32_t(next * 4 + d);
+      if (s.stamp[reached] == s.round && s.cost[reached] <= cost)
+        continue;
+      s.stamp[reached]  = s.round;
+      s.cost[reached]   = cost;
+      s.parent[reached] = state;
+      open.push({cost + heuristic(nx, ny), reached});
+    }
+  }
+  if (bestGoal < 0)
+    return {};
+
+  std::vector<glm::vec2> path;
+  path.push_back(end);
+  for (int32_t state = bestGoal; state >= 0; state = s.parent[state]) {
+    size_t const point = state / 4;
+    path.emplace_back(s.xs[point % w], s.ys[point / w]);
+  }
+  path.push_back(start);
+  std::reverse(path.begin(), path.end());
+  dropCollinear(path);
+  return path;
+}
+
+} // namespace linkrouter
+} // namespace editorui
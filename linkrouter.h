@@ -0,0 +1,216 @@
+#pragma once
+// orthogonal link routes around node rectangles, and the spatial index to find them by
+// no ImGui in here - the model and headless tools use it too
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace editorui {
+namespace linkrouter {
+
+struct Rect
+{
+  glm::vec2 min, max;
+
+  bool intersects(Rect const& r) const
+  {
+    return min.x <= r.max.x && r.min.x <= max.x && min.y <= r.max.y && r.min.y <= max.y;
+  }
+  bool contains(glm::vec2 const& p) const // strictly, points on the border are outside
+  {
+    return min.x < p.x && p.x < max.x && min.y < p.y && p.y < max.y;
+  }
+  bool operator==(Rect const& r) const { return min == r.min && max == r.max; }
+  bool operator!=(Rect const& r) const { return !(*this == r); }
+};
+
+/// rectangles by key on a uniform grid of square cells, for rectangle queries
+/// rectangles spanning more than MAX_CELLS cells are kept aside in a list that every query
+/// walks, so that long links do not flood the grid
+template<class Key, class KeyHash = std::hash<Key>>
+class SpatialHash
+{
+public:
+  static constexpr int MAX_CELLS = 256;
+
+  explicit SpatialHash(float cellSize = 256.f) : cellSize_(cellSize) {}
+
+  size_t size() const { return entries_.size(); }
+
+  Rect const* find(Key const& key) const
+  {
+    auto itr = entries_.find(key);
+    return itr == entries_.end() ? nullptr : &itr->second.rect;
+  }
+
+  /// calls fn(key, rect) for every rectangle
+  template<class Fn>
+  void forEach(Fn&& fn) const
+  {
+    for (auto const& entry : entries_)
+      fn(entry.first, entry.second.rect);
+  }
+
+  /// inserts key, or moves it if it is already there
+  void insert(Key const& key, Rect const& rect)
+  {
+    Entry entry = cover(rect);
+    auto  itr   = entries_.find(key);
+    if (itr != entries_.end()) {
+      Entry& old = itr->second;
+      if (old.x0 == entry.x0 && old.y0 == entry.y0 && old.x1 == entry.x1 && old.y1 == entry.y1) {
+        old.rect = rect;
+        return;
+      }
+      unlink(key, old);
+      old = entry;
+    } else {
+      entries_.emplace(key, entry);
+    }
+    link(key, entry);
+  }
+
+  void erase(Key const& key)
+  {
+    auto itr = entries_.find(key);
+    if (itr == entries_.end())
+      return;
+    unlink(key, itr->second);
+    entries_.erase(itr);
+  }
+
+  void clear()
+  {
+    entries_.clear();
+    cells_.clear();
+    large_.clear();
+  }
+
+  /// calls fn(key, rect) once for each rectangle intersecting area, until fn returns false
+  /// returns false if stopped by fn
+  template<class Fn>
+  bool query(Rect const& area, Fn&& fn) const
+  {
+    Entry const q = cover(area);
+    if (q.large) { // as many cells as a large rectangle, walk everything instead
+      for (auto const& entry : entries_)
+        if (entry.second.rect.intersects(area) && !fn(entry.first, entry.second.rect))
+          return false;
+      return true;
+    }
+    for (int y = q.y0; y <= q.y1; ++y) {
+      for (int x = q.x0; x <= q.x1; ++x) {
+        auto cell = cells_.find(cellKey(x, y));
+        if (cell == cells_.end())
+          continue;
+        for (Key const& key : cell->second) {
+          Entry const& entry = entries_.find(key)->second;
+          // a rectangle is in several cells, report it from the first one the query shares
+          if (x == std::max(q.x0, entry.x0) && y == std::max(q.y0, entry.y0) &&
+              entry.rect.intersects(area) && !fn(key, entry.rect))
+            return false;
+        }
+      }
+    }
+    for (Key const& key : large_) {
+      Entry const& entry = entries_.find(key)->second;
+      if (entry.rect.intersects(area) && !fn(key, entry.rect))
+        return false;
+    }
+    return true;
+  }
+
+private:
+  struct Entry
+  {
+    Rect rect;
+    int  x0, y0, x1, y1; // cells covered, inclusive
+    bool large;
+  };
+
+  float                                          cellSize_;
+  std::unordered_map<Key, Entry, KeyHash>        entries_;
+  std::unordered_map<uint64_t, std::vector<Key>> cells_;
+  std::vector<Key>                               large_;
+
+  static uint64_t cellKey(int x, int y) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(y); }
+
+  Entry cover(Rect const& rect) const
+  {
+    Entry entry;
+    entry.rect  = rect;
+    entry.x0    = int(std::floor(rect.min.x / cellSize_));
+    entry.y0    = int(std::floor(rect.min.y / cellSize_));
+    entry.x1    = int(std::floor(rect.max.x / cellSize_));
+    entry.y1    = int(std::floor(rect.max.y / cellSize_));
+    entry.large = int64_t(entry.x1 - entry.x0 + 1) * (entry.y1 - entry.y0 + 1) > MAX_CELLS;
+    return entry;
+  }
+
+  static void removeKey(std::vector<Key>& keys, Key const& key)
+  {
+    auto itr = std::find(keys.begin(), keys.end(), key);
+    if (itr != keys.end()) {
+      *itr = keys.back();
+      keys.pop_back();
+    }
+  }
+
+  void link(Key const& key, Entry const& entry)
+  {
+    if (entry.large) {
+      large_.push_back(key);
+      return;
+    }
+    for (int y = entry.y0; y <= entry.y1; ++y)
+      for (int x = entry.x0; x <= entry.x1; ++x)
+        cells_[cellKey(x, y)].push_back(key);
+  }
+
+  void unlink(Key const& key, Entry const& entry)
+  {
+    if (entry.large) {
+      removeKey(large_, key);
+      return;
+    }
+    for (int y = entry.y0; y <= entry.y1; ++y) {
+      for (int x = entry.x0; x <= entry.x1; ++x) {
+        auto cell = cells_.find(cellKey(x, y));
+        removeKey(cell->second, key);
+        if (cell->second.empty())
+          cells_.erase(cell);
+      }
+    }
+  }
+};
+
+/// space kept between routes and the nodes they pass
+constexpr float MARGIN = 8.f;
+/// length of the vertical stubs leaving an output pin and entering an input pin
+constexpr float EXTEND = 16.f;
+/// routes are not searched through areas holding more nodes, which keeps the search
+/// within a fraction of a millisecond; such links are laid out like Graph::genLinkPath()
+constexpr size_t MAX_OBSTACLES = 128;
+
+/// area searched for a route from an output pin at start to an input pin at end,
+/// obstacles outside of it can be left out, no route is searched if it holds more than
+/// MAX_OBSTACLES
+Rect searchArea(glm::vec2 const& start, glm::vec2 const& end);
+
+/// orthogonal path from an output pin at start to an input pin at end, leaving and entering
+/// vertically and keeping MARGIN off the obstacles (node rectangles), with as few bends as
+/// a short path allows; tracks run along the obstacle borders, so nearby links share them
+/// returns the control polygon like Graph::genLinkPath(), empty if searchArea() holds no route
+/// or too many obstacles
+std::vector<glm::vec2> route(glm::vec2 const&         start,
+                             glm::vec2 const&         end,
+                             std::vector<Rect> const& obstacles);
+
+} // namespace linkrouter
+} // namespace editorui
@@ -3,6 +3,10 @@
 
 #include "main.h"
 #include "nodegraph.h"
+#include "inputsession.h"
+#include "latency.h"
+#include "profiler.h"
+#include "tracer.h"
 #include <spdlog/spdlog.h>
 #ifdef _WIN32
 #include <spdlog/sinks/wincolor_sink.h>
@@ -15,6 +19,7 @@
 
 #include <imgui.h>
 #include <math.h> // fmodf
+#include <stdlib.h> // getenv
 
 namespace app {
 
@@ -110,6 +115,7 @@ std::map<std::string, int> MyTestHook::typeNumericSuffix;
 
 editorui::Graph graph;
 MyTestHook hook;
+std::string tracePath; // from NODEGRAPH_TRACE, written on quit
 
 void init()
 {
@@ -156,6 +162,14 @@ void init()
   }
   graph.addViewer();
   graph.addViewer();
+
+  editorui::trace::setThreadName("main");
+  if (char const* path = getenv(editorui::trace::ENV_VAR)) {
+    tracePath = path;
+    graph.setHookInstrumented(true);
+    editorui::trace::start();
+    spdlog::info("recording trace to \"{}\"", tracePath);
+  }
 }
 
 bool show_demo_window = true;
@@ -164,10 +178,32 @@ bool show_ng_window = true;
 float clear_color[3] = { 0.1f,0.1f,0.1f };
 
 void update() {
+  editorui::profiler::beginFrame();
+  editorui::latency::beginFrame();
+  editorui::session::recordFrame();
+  if (editorui::session::recording())
+    graph.finishLinkPaths(); // recorded clicks must not hit paths the worker is yet to build
   ImGui::DockSpaceOverViewport();
   editorui::edit(graph, "Demo NodeGraph");
+  editorui::profiler::endFrame();
 }
 
-void quit() {}
+bool needsFrame() {
+  return editorui::needsFrame(graph);
+}
+
+void setWakeHandler(void (*wake)()) {
+  editorui::setWakeHandler(wake);
+}
+
+void quit() {
+  if (!tracePath.empty()) {
+    editorui::trace::stop();
+    if (editorui::trace::write(tracePath))
+      spdlog::info("wrote {} trace events to \"{}\"", editorui::trace::eventCount(), tracePath);
+    else
+      spdlog::error("cannot open \"{}\" for writing", tracePath);
+  }
+}
 
 } // namespace app
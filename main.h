@@ -1,8 +1,19 @@
 #pragma once
 
+namespace editorui {
+class Graph;
+}
+
 namespace app {
 void init();
 void update();
 void quit();
-}
 
+extern editorui::Graph graph; // the edited graph, e.g. for replaying recorded sessions
+
+// render on demand: loops may sleep, for at most IDLE_TIMEOUT_SECONDS, while this is false
+bool needsFrame();
+constexpr double IDLE_TIMEOUT_SECONDS = 0.5;
+// lets other threads interrupt that sleep, e.g. when the hook requests a repaint
+void setWakeHandler(void (*wake)());
+}
@@ -1,4 +1,12 @@
 #include "nodegraph.h"
+#include "governor.h"
+#include "inputsession.h"
+#include "instrumentedhook.h"
+#include "latency.h"
+#include "layout.h"
+#include "profiler.h"
+#include "tracer.h"
+#include "transform2d.h"
 
 #define IMGUI_DEFINE_MATH_OPERATORS 1
 #include <imgui.h>
@@ -19,7 +27,10 @@
 #include <nlohmann/json.hpp>
 
 #include <fstream>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <memory>
 
 // --------------------------------------------------------------------
@@ -170,13 +181,55 @@ struct AABB
   }
 };
 
+// counts vertices & indices emitted into a draw list during its lifetime
+class DrawListCounter
+{
+  ImDrawList* drawList_;
+  int         vtxPhase_, idxPhase_;
+  int         vtxStart_, idxStart_;
+
+public:
+  DrawListCounter(ImDrawList* drawList, int vtxPhase, int idxPhase)
+      : drawList_(drawList)
+      , vtxPhase_(vtxPhase)
+      , idxPhase_(idxPhase)
+      , vtxStart_(drawList->VtxBuffer.Size)
+      , idxStart_(drawList->IdxBuffer.Size)
+  {
+  }
+  ~DrawListCounter()
+  {
+    editorui::profiler::count(vtxPhase_, drawList_->VtxBuffer.Size - vtxStart_);
+    editorui::profiler::count(idxPhase_, drawList_->IdxBuffer.Size - idxStart_);
+  }
+};
+
+// times the enclosing block as phase `name`, and counts its emitted geometry
+// into phases `name.vtx` & `name.idx`
+#define NG_PROFILE_DRAW_SCOPE(name, drawList)                                                \
+  NG_PROFILE_SCOPE(name);                                                                    \
+  static int const NG_PROFILE_CONCAT(ngVtxPhase, __LINE__) =                                 \
+      ::editorui::profiler::phaseId(name ".vtx");                                            \
+  static int const NG_PROFILE_CONCAT(ngIdxPhase, __LINE__) =                                 \
+      ::editorui::profiler::phaseId(name ".idx");                                            \
+  DrawListCounter NG_PROFILE_CONCAT(ngDrawCounter, __LINE__)(                                \
+      drawList, NG_PROFILE_CONCAT(ngVtxPhase, __LINE__), NG_PROFILE_CONCAT(ngIdxPhase, __LINE__))
+
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float) && sizeof(ImVec2) == 2 * sizeof(float),
+              "points are handed to transform2d as float pairs");
+
+// mat is a canvas to screen matrix (see calcToScreenMatrix): a uniform scale and a translation,
+// so n points are mapped in one vectorized pass
+static void transform(glm::vec2 const* src, size_t n, glm::mat3 const& mat, ImVec2* dst)
+{
+  if (n > 0)
+    transform2d::scaleTranslate(&src->x, &dst->x, n, mat[0][0], mat[2][0], mat[2][1]);
+}
+
 static std::vector<ImVec2> transform(std::vector<glm::vec2> const& src, glm::mat3 const& mat)
 {
   std::vector<ImVec2> result(src.size());
-  std::transform(src.begin(), src.end(), result.begin(), [&mat](glm::vec2 const& v) {
-    auto t = mat * glm::vec3(v, 1);
-    return ImVec2(t.x, t.y);
-  });
+  transform(src.data(), src.size(), mat, result.data());
   return result;
 }
 
@@ -232,6 +285,15 @@ static float pointSegmentDistance(Vec2 const& pt,
   return length(diff);
 }
 
+// the path a link is drawn along, to hit test what the user sees
+static std::vector<glm::vec2> drawnLinkPath(Graph const&                    graph,
+                                            GraphGeometry::LinkShape const& link)
+{
+  if (link.bundle >= 0)
+    return graph.geometry().bundles[link.bundle]->path(link.branch);
+  return graph.linkPath(link.input);
+}
+
 static ptrdiff_t longestCommonSequenceLength(std::string const& a, std::string const& b)
 {
   std::string const& from = a.length() > b.length() ? b : a;
@@ -415,6 +477,14 @@ static auto& globalConfig()
       ImFont* stdIconFont = nullptr;
       ImFont* largeIconFont = nullptr;
     } fonts;
+    size_t undoHistoryBudget = size_t(256) << 20;
+    bool   renderOnDemand    = true;
+    bool   cacheStaticLayer  = true;  // see drawGraph()
+    float  drawBudgetMs      = 8.f;   // for recording the static layer per frame, 0: no limit
+    float  linkTolerance     = 0.25f; // pixels link curves may be off by when tessellated
+    bool   linkPathWorker    = false; // see Graph::setLinkPathWorker()
+    bool   linkRouting       = false; // see Graph::setLinkRouting()
+    bool   linkBundling      = false; // see Graph::setLinkBundling()
   } config;
   return config;
 }
@@ -486,39 +556,6 @@ FontScope::~FontScope()
   ImGui::PopFont();
 }
 
-NodeIdAllocator* NodeIdAllocator::instance_ = nullptr;
-NodeIdAllocator& NodeIdAllocator::instance()
-{
-  static std::unique_ptr<NodeIdAllocator> s_instance(new NodeIdAllocator);
-  if (instance_ == nullptr)
-    instance_ = s_instance.get();
-  return *s_instance;
-}
-
-void GraphView::onGraphChanged()
-{
-  if (graph) {
-    if (!nodeSelection.empty()) {
-      std::vector<size_t> invalidIndices;
-      for (size_t idx : nodeSelection) {
-        if (graph->nodes().find(idx) == graph->nodes().end()) {
-          invalidIndices.push_back(idx);
-        }
-      }
-      for (size_t idx : invalidIndices)
-        nodeSelection.erase(idx);
-    }
-    if (activeNode != -1 && graph->nodes().find(activeNode) != graph->nodes().end())
-      activeNode = -1;
-    if (graph->nodes().find(focusingNode) == graph->nodes().end()) {
-      if (kind == Kind::INSPECTOR)
-        showInspector = false;
-      if (kind == Kind::DATASHEET)
-        showDatasheet = false;
-    }
-  }
-}
-
 void GraphView::copy()
 {
   if (!nodeSelection.empty()) {
@@ -560,329 +597,12 @@ bool GraphView::paste()
   }
 }
 
-// TODO: too naive, refactor this
-class UndoStackImpl : public UndoStack
-{
-  std::vector<nlohmann::json> history_;
-  ptrdiff_t                   cursor_=-1;
-public:
-  bool stash(Graph const& g) override
-  {
-    if (cursor_ + 1 < ptrdiff_t(history_.size())) // 0 reserved
-      history_.resize(cursor_ + 1);
-    if (g.save(history_.emplace_back(), "")) {
-      ++cursor_;
-      return true;
-    }
-    return false;
-  }
-  bool undo(Graph& g) override
-  {
-    if (history_.empty() || cursor_ < 1)
-      return false;
-    --cursor_;
-    assert(cursor_<history_.size());
-    return g.load(history_[cursor_], "");
-  }
-  bool redo(Graph& g) override
-  {
-    if (history_.empty() || cursor_ + 1 >= ptrdiff_t(history_.size()))
-      return false;
-    ++cursor_;
-    return g.load(history_[cursor_], "");
-  }
-};
-
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(glm::vec4, x, y, z, w);
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(glm::vec3, x, y, z);
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(glm::vec2, x, y);
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NodePin, type, nodeIndex, pinNumber);
-
-std::vector<glm::vec2> Graph::genLinkPath(glm::vec2 const& start,
-                                          glm::vec2 const& end,
-                                          float            avoidenceWidth)
-{
-  std::vector<glm::vec2> path;
-  const float LOOP_CORNER_SIZE = 8.f;
-  const float EXTEND = 16.f;
-
-  float xcenter  = (start.x + end.x) * 0.5f;
-  float ycenter  = (start.y + end.y) * 0.5f;
-  float const dx = end.x - start.x;
-  float const dy = end.y - start.y;
-  auto  sign     = [](float x) { return x > 0 ? 1 : x < 0 ? -1 : 0; };
-
-  if (dy < EXTEND*2 + LOOP_CORNER_SIZE*2) {
-    if (fabs(dx)<=fabs(dy)*2) {
-      // xcenter += sign(dx) * avoidenceWidth;
-      xcenter = start.x - sign(dx) * avoidenceWidth;
-    }
-    auto endextend = end + glm::vec2(0, -EXTEND);
-    float const restdy = dy - EXTEND*2;
-
-    path.push_back(start);
-    path.push_back(start + glm::vec2(0, EXTEND));
-    if (fabs(dx) > fabs(restdy)*2 + LOOP_CORNER_SIZE * 8) {
-      path.emplace_back(start.x + sign(dx) * LOOP_CORNER_SIZE, path.back().y + LOOP_CORNER_SIZE);
-      path.emplace_back(xcenter - sign(dx * restdy) * restdy / 2 - sign(dx) * LOOP_CORNER_SIZE, path.back().y);
-      path.emplace_back(xcenter + sign(dx * restdy) * restdy / 2 + sign(dx) * LOOP_CORNER_SIZE, endextend.y - LOOP_CORNER_SIZE);
-      path.emplace_back(end.x - sign(dx) * LOOP_CORNER_SIZE, endextend.y - LOOP_CORNER_SIZE);
-    } else if (restdy < 0) {
-      path.emplace_back(start.x + sign(xcenter - start.x) * LOOP_CORNER_SIZE, start.y + EXTEND + LOOP_CORNER_SIZE);
-      path.emplace_back(xcenter - sign(xcenter - start.x) * LOOP_CORNER_SIZE, path.back().y);
-      path.emplace_back(xcenter, path.back().y - LOOP_CORNER_SIZE);
-      path.emplace_back(xcenter, endextend.y);
-      path.emplace_back(xcenter + sign(end.x - xcenter) * LOOP_CORNER_SIZE, endextend.y - LOOP_CORNER_SIZE);
-      path.emplace_back(end.x - sign(end.x - xcenter) * LOOP_CORNER_SIZE, end.y - EXTEND - LOOP_CORNER_SIZE);
-    }
-    path.push_back(endextend);
-    path.push_back(end);
-  } else {
-    path.push_back(start);
-    if (fabs(dx) >= 0.33f) {
-      if (dy > fabs(dx) + 42) {
-        if (dy < 80) {
-          path.emplace_back(start.x, ycenter - fabs(dx) / 2);
-          path.emplace_back(end.x, ycenter + fabs(dx) / 2);
-        } else {
-          path.emplace_back(start.x, end.y - fabs(dx) - 20);
-          path.emplace_back(end.x, end.y - 20);
-        }
-      } else if (dy>40) {
-        path.emplace_back(start.x, start.y + 20);
-        if (dy < fabs(dx) + 40) {
-          path.emplace_back(start.x + sign(dx) * (dy - 40) / 2, ycenter);
-          path.emplace_back(end.x - sign(dx) * (dy - 40) / 2, ycenter);
-        }
-        path.emplace_back(end.x, end.y - 20);
-      }
-    }
-    path.push_back(end);
-  }
-  return path;
-}
-
-
-bool Graph::partialSave(nlohmann::json& json, std::set<size_t> const& nodes)
-{
-  auto& uigraph = json["uigraph"];
-  auto& nodesection = uigraph["nodes"];
-  for (size_t id : nodes) {
-    auto const& node = noderef(id);
-    nlohmann::json nodedef;
-    nodedef["id"] = id;
-    nodedef["initialName"] = node.initialName();
-    nodedef["displayName"] = node.displayName();
-    nodedef["minInputs"] = node.minInputCount();
-    nodedef["maxInputs"] = node.maxInputCount();
-    nodedef["nOutputs"] = node.outputCount();
-    to_json(nodedef["color"], node.color());
-    to_json(nodedef["pos"], node.pos());
-    nodesection.push_back(nodedef);
-  }
-  auto& linksection = uigraph["links"];
-  for (auto const& link : links_) {
-    if (nodes.find(link.first.nodeIndex) != nodes.end()/* || nodes.find(link.second.nodeIndex) != nodes.end()*/) {
-      nlohmann::json linkdef;
-      linkdef["from"] = link.second;
-      linkdef["fromname"] = noderef(link.second.nodeIndex).displayName();
-      linkdef["to"] = link.first;
-      linksection.push_back(linkdef);
-    }
-  }
-  if (hook_)
-    return hook_->onPartialSave(this, json, nodes);
-  return true;
-}
-
-bool Graph::partialLoad(nlohmann::json const& json, std::set<size_t> *outPastedNodes)
-{
-  if (!json.is_object() || json.find("uigraph") == json.end())
-    return false;
-  auto const& uigraph = json["uigraph"];
-  std::unordered_map<size_t, size_t> idMap;
-  for (auto const& nodedef: uigraph["nodes"]) {
-    glm::vec2 pos;
-    from_json(nodedef["pos"], pos);
-    auto newid = addNode(nodedef["initialName"], nodedef["displayName"], pos + glm::vec2(100, 100));
-    Node& node = noderef(newid);
-    node.numInputs_ = nodedef["maxInputs"];
-    node.numOutputs_ = nodedef["nOutputs"];
-    from_json(nodedef["color"], node.color_);
-
-    idMap[nodedef["id"]] = newid;
-  }
-  auto transpin = [&idMap](NodePin const& pin) {
-    auto itr = idMap.find(pin.nodeIndex);
-    return NodePin{ pin.type, itr == idMap.end() ? pin.nodeIndex : itr->second, pin.pinNumber };
-  };
-  for (auto const& linkdef: uigraph["links"]) {
-    auto to = transpin(linkdef["to"]);
-    NodePin from = linkdef["from"];
-    // auto from = transpin(linkdef["from"]);
-    if (auto itr = idMap.find(from.nodeIndex); itr!=idMap.end())
-      from.nodeIndex = itr->second;
-    // resolve link by display name - for copy-pasting between totally different graphs
-    // where ids makes no sense
-    else if (linkdef.find("fromname")!=linkdef.end()) {
-      if (auto sourceitr=std::find_if(
-            nodes_.begin(), nodes_.end(),
-            [name=std::string(linkdef["fromname"])](auto const& pair) {
-              return pair.second.displayName()==name;
-            });
-          sourceitr!=nodes_.end())
-      {
-        from.nodeIndex = sourceitr->first;
-      }
-    }
-    if (nodes_.find(to.nodeIndex) != nodes_.end() && nodes_.find(from.nodeIndex) != nodes_.end())
-      addLink(from.nodeIndex, from.pinNumber, to.nodeIndex, to.pinNumber);
-  }
-  for (auto const& newitem: idMap) {
-    updateLinkPath(newitem.second);
-  }
-
-  std::set<size_t> newNodes;
-  newNodes.clear();
-  for (auto const& newitem : idMap) {
-    newNodes.insert(newitem.second);
-  }
-  if (outPastedNodes) {
-    *outPastedNodes = newNodes;
-  }
-  bool succeed = true;
-  if (hook_)
-    succeed &= hook_->onPartialLoad(this, json, newNodes, idMap);
-
-  this->notifyViewers();
-  stash();
-  return succeed;
-}
-
-bool Graph::save(nlohmann::json& section, std::string const& path) const
-{
-  auto& uigraph = section["uigraph"];
-  auto& nodesection = uigraph["nodes"];
-  for (auto const& n : nodes_) {
-    nlohmann::json nodedef;
-    nodedef["id"] = n.first;
-    nodedef["initialName"] = n.second.initialName();
-    nodedef["displayName"] = n.second.displayName();
-    nodedef["minInputs"] = n.second.minInputCount();
-    nodedef["maxInputs"] = n.second.maxInputCount();
-    nodedef["nOutputs"] = n.second.outputCount();
-    to_json(nodedef["color"], n.second.color());
-    to_json(nodedef["pos"],   n.second.pos());
-
-    nodesection.push_back(nodedef);
-  }
-  auto& linksection = uigraph["links"];
-  for (auto const& link: links_) {
-    nlohmann::json linkdef;
-    linkdef["from"] = { {"node", link.second.nodeIndex}, {"pin", link.second.pinNumber} };
-    linkdef["to"] = { {"node", link.first.nodeIndex}, {"pin", link.first.pinNumber} };
-
-    linksection.push_back(linkdef);
-  }
-  uigraph["order"] = nodeOrder_;
-
-  if (hook_) {
-    hook_->onSave(this, section, path);
-  }
-  if (!path.empty())
-    savePath_ = path;
-
-  return true;
-}
-
-static void focusSelected(GraphView& gv);
-bool Graph::load(nlohmann::json const& section, std::string const& path)
-{
-  if (hook_) {
-    for (auto& n : nodes_) {
-      hook_->beforeDeleteNode(&n.second);
-    }
-  }
-  nodes_.clear();
-  links_.clear();
-  linkPathes_.clear();
-  nodeOrder_.clear();
-
-  auto const& uigraph = section["uigraph"];
-  size_t maxNodeId = 0;
-  for (auto const& n: uigraph["nodes"]) {
-    Node node;
-    node.initialName_ = n["initialName"];
-    node.displayName_ = n["displayName"];
-    node.numInputs_ = n["maxInputs"];
-    node.numOutputs_ = n["nOutputs"];
-    node.hook_ = nullptr; // Hooks are processed later
-    from_json(n["color"], node.color_);
-    from_json(n["pos"], node.pos_);
-
-    size_t id = n["id"];
-    nodes_[id] = node;
-
-    maxNodeId = std::max(id, maxNodeId);
-  }
-  NodeIdAllocator::instance().setInitialId(maxNodeId+1);
-  for (auto const& link: uigraph["links"]) {
-    links_[NodePin{ NodePin::INPUT,link["to"]["node"], link["to"]["pin"] }] = NodePin{ NodePin::OUTPUT, link["from"]["node"], link["from"]["pin"] };
-  }
-  if (uigraph.find("order")!=uigraph.end()) {
-    for (size_t id : uigraph["order"]) {
-      nodeOrder_.push_back(id);
-    }
-  } else {
-    for (auto const& n : nodes_)
-      nodeOrder_.push_back(n.first);
-  }
-
-  for(auto const& n: nodes_)
-    updateLinkPath(n.first);
-
-  bool succeed = true;
-  if(hook_) {
-    succeed &= hook_->onLoad(this, section, path);
-  }
-  this->notifyViewers();
-  if (!path.empty()) {
-    undoStack_.reset(nullptr);
-    stash();
-    savePath_ = path;
-    for (auto *v: viewers_) {
-      focusSelected(*v);
-    }
-  }
-  return succeed;
-}
-
-bool Graph::stash()
-{
-  if (!undoStack_)
-    undoStack_.reset(new UndoStackImpl());
-  return undoStack_->stash(*this);
-}
-
-bool Graph::undo()
-{
-  if (!undoStack_)
-    return false;
-  return undoStack_->undo(*this);
-}
-
-bool Graph::redo()
-{
-  if (!undoStack_)
-    return false;
-  return undoStack_->redo(*this);
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////
 
 
 void updateInspectorView(GraphView& gv, char const* name)
 {
+  NG_PROFILE_SCOPE("updateInspectorView");
   if (!gv.showInspector)
     return;
   ImGui::SetNextWindowSize(ImVec2{320, 480}, ImGuiCond_FirstUseEver);
@@ -899,15 +619,19 @@ void updateInspectorView(GraphView& gv, char const* name)
     if (ImGui::InputText("Name##nodename",
       namebuf,
       sizeof(namebuf),
-      ImGuiInputTextFlags_CharsNoBlank | ImGuiInputTextFlags_EnterReturnsTrue))
+      ImGuiInputTextFlags_CharsNoBlank | ImGuiInputTextFlags_EnterReturnsTrue)) {
       node.setDisplayName(namebuf);
+      gv.graph->markChanged();
+    }
     // if (ImGui::SliderInt("Number of Inputs", &node.maxInputCount(), 0, 20))
     //  gv.graph->updateLinkPath(id);
     // if (ImGui::SliderInt("Number of Outputs", &node.outputCount(), 0, 20))
     //  gv.graph->updateLinkPath(id);
     auto color = node.color();
-    if (ImGui::ColorEdit4("Color", &color.r, ImGuiColorEditFlags_PickerHueWheel))
+    if (ImGui::ColorEdit4("Color", &color.r, ImGuiColorEditFlags_PickerHueWheel)) {
       node.setColor(color);
+      gv.graph->markChanged();
+    }
 
     ImGui::Separator();
 
@@ -933,6 +657,7 @@ void updateInspectorView(GraphView& gv, char const* name)
         for (auto id : gv.nodeSelection) {
           gv.graph->noderef(id).setColor(avgColor);
         }
+        gv.graph->markChanged();
         gv.graph->stash();
       }
       // TODO: multi-editing
@@ -959,15 +684,881 @@ static int circleSegs(float radius)
   //0, 1, 2, 3, 4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15
     4, 4, 6, 6, 7,  8,  9,  9,  9, 10, 10, 12, 12, 13, 13, 14
   };
-  if (int(radius)<sizeof(lut)/sizeof(lut[0])) {
-    return lut[int(radius)];
-  } else {
-    return std::max(36, int(radius));
+  int const segs = int(radius) < sizeof(lut) / sizeof(lut[0]) ? lut[int(radius)]
+                                                              : std::max(36, int(radius));
+  if (governor::tier() != governor::Tier::FULL)
+    return std::max(4, segs / 2);
+  return segs;
+}
+
+// canvas space tolerance to tessellate link curves with (see Graph::tessellateLinkPath)
+static float linkTolerance(float canvasScale)
+{
+  float const px = globalConfig().linkTolerance;
+  return (governor::tier() >= governor::Tier::REDUCED ? 2 * px : px) / canvasScale;
+}
+
+// node shapes {{{
+// node bodies and pins are written straight into the draw list from unit outlines computed once
+// per segment count, all shapes queued for a node in one PrimReserve(), anti-aliased the way
+// ImGui fills convex polygons: an opaque inner ring and a transparent fringe around it
+
+struct ShapeTemplate
+{
+  std::vector<ImVec2> dir;    // point i is at center + corner[i] * inset + dir[i] * radius
+  std::vector<ImVec2> corner; // for rounded rects, which corner point i belongs to (-1 or 1)
+  std::vector<ImVec2> fringe; // half the vertex normal, as ImGui computes it
+};
+
+static void computeFringe(ShapeTemplate& tpl, std::vector<ImVec2> const& sample)
+{
+  size_t const        n = sample.size();
+  std::vector<ImVec2> edgeNormals(n);
+  for (size_t i = 0; i < n; ++i) {
+    ImVec2 d   = sample[(i + 1) % n] - sample[i];
+    float  len = d.x * d.x + d.y * d.y;
+    if (len > 0)
+      d = d / std::sqrt(len);
+    edgeNormals[i] = ImVec2(d.y, -d.x);
+  }
+  tpl.fringe.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    ImVec2      dm = (edgeNormals[(i + n - 1) % n] + edgeNormals[i]) * 0.5f;
+    float const d2 = dm.x * dm.x + dm.y * dm.y;
+    if (d2 > 1e-6f)
+      dm = dm * std::min(1.f / d2, 100.f);
+    tpl.fringe[i] = dm * 0.5f;
   }
 }
 
+static ShapeTemplate const& circleTemplate(int segs)
+{
+  static std::unordered_map<int, ShapeTemplate> cache;
+  auto& tpl = cache[segs];
+  if (tpl.dir.empty()) {
+    for (int i = 0; i < segs; ++i) {
+      float const a = 2 * glm::pi<float>() * i / segs;
+      tpl.dir.emplace_back(std::cos(a), std::sin(a));
+    }
+    tpl.corner.assign(segs, ImVec2(0, 0));
+    computeFringe(tpl, tpl.dir);
+  }
+  return tpl;
+}
+
+// segs per corner, 0 for sharp corners; clockwise from the top left like ImDrawList::PathRect
+static ShapeTemplate const& roundedRectTemplate(int segs)
+{
+  static std::unordered_map<int, ShapeTemplate> cache;
+  auto& tpl = cache[segs];
+  if (tpl.dir.empty()) {
+    ImVec2 const        corners[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    std::vector<ImVec2> sample; // edge directions do not depend on the size, any will do
+    for (int c = 0; c < 4; ++c) {
+      for (int i = 0; i <= segs; ++i) {
+        float const a   = glm::pi<float>() * (1 + c * 0.5f + (segs ? 0.5f * i / segs : 0.25f));
+        ImVec2      dir = segs ? ImVec2(std::cos(a), std::sin(a)) : ImVec2(0, 0);
+        tpl.dir.push_back(dir);
+        tpl.corner.push_back(corners[c]);
+        sample.push_back(corners[c] + (segs ? dir : corners[c]));
+      }
+    }
+    computeFringe(tpl, sample);
+  }
+  return tpl;
+}
+
+struct ShapeQueue
+{
+  struct Shape
+  {
+    ShapeTemplate const* tpl;
+    ImVec2               center;
+    ImVec2               inset; // half size minus radius for rounded rects
+    float                radius;
+    ImU32                color;
+  };
+  std::vector<Shape> shapes;
+
+  void circle(ImVec2 const& center, float radius, ImU32 color, int segs)
+  {
+    push({&circleTemplate(segs), center, ImVec2(0, 0), radius, color});
+  }
+
+  // rounding is clamped and dropped below a pixel like ImDrawList::AddRectFilled does
+  void roundedRect(ImVec2 const& min, ImVec2 const& max, ImU32 color, float rounding)
+  {
+    ImVec2 const half = (max - min) * 0.5f;
+    rounding = std::min({rounding, std::abs(half.x) - 1, std::abs(half.y) - 1});
+    int const segs = rounding > 0.5f ? std::clamp(circleSegs(rounding) / 4, 1, 8) : 0;
+    if (segs == 0)
+      rounding = 0;
+    push({&roundedRectTemplate(segs),
+          (min + max) * 0.5f,
+          ImVec2(std::abs(half.x) - rounding, std::abs(half.y) - rounding),
+          rounding,
+          color});
+  }
+
+  void push(Shape const& shape) { shapes.push_back(shape); }
+
+  // writes all queued shapes, split in reservations small enough for 16 bit indices
+  void flush(ImDrawList* drawList)
+  {
+    constexpr int MAX_VTX     = 1 << 15;
+    bool const    antiAliased = drawList->Flags & ImDrawListFlags_AntiAliasedFill;
+    ImVec2 const  uv          = drawList->_Data->TexUvWhitePixel;
+    for (size_t first = 0; first < shapes.size();) {
+      size_t last = first;
+      int    vtx  = 0;
+      int    idx  = 0;
+      for (; last < shapes.size(); ++last) {
+        int const n = int(shapes[last].tpl->dir.size());
+        int const v = antiAliased ? n * 2 : n;
+        if (last > first && vtx + v > MAX_VTX)
+          break;
+        vtx += v;
+        idx += antiAliased ? (n - 2) * 3 + n * 6 : (n - 2) * 3;
+      }
+      drawList->PrimReserve(idx, vtx);
+      ImDrawVert* vw   = drawList->_VtxWritePtr;
+      ImDrawIdx*  iw   = drawList->_IdxWritePtr;
+      unsigned    base = drawList->_VtxCurrentIdx;
+      for (size_t s = first; s < last; ++s) {
+        auto const& shape       = shapes[s];
+        auto const& tpl         = *shape.tpl;
+        unsigned    n           = unsigned(tpl.dir.size());
+        ImU32 const transparent = shape.color & ~IM_COL32_A_MASK;
+        for (unsigned i = 0; i < n; ++i) {
+          ImVec2 const pos = ImVec2(shape.center.x + tpl.corner[i].x * shape.inset.x,
+                                    shape.center.y + tpl.corner[i].y * shape.inset.y) +
+                             tpl.dir[i] * shape.radius;
+          if (antiAliased) {
+            *vw++ = {pos - tpl.fringe[i], uv, shape.color};
+            *vw++ = {pos + tpl.fringe[i], uv, transparent};
+          } else {
+            *vw++ = {pos, uv, shape.color};
+          }
+        }
+        unsigned const step = antiAliased ? 2 : 1;
+        for (unsigned i = 2; i < n; ++i) {
+          *iw++ = ImDrawIdx(base);
+          *iw++ = ImDrawIdx(base + (i - 1) * step);
+          *iw++ = ImDrawIdx(base + i * step);
+        }
+        if (antiAliased) {
+          for (unsigned i0 = n - 1, i1 = 0; i1 < n; i0 = i1++) {
+            *iw++ = ImDrawIdx(base + i1 * 2);
+            *iw++ = ImDrawIdx(base + i0 * 2);
+            *iw++ = ImDrawIdx(base + i0 * 2 + 1);
+            *iw++ = ImDrawIdx(base + i0 * 2 + 1);
+            *iw++ = ImDrawIdx(base + i1 * 2 + 1);
+            *iw++ = ImDrawIdx(base + i1 * 2);
+          }
+        }
+        base += n * step;
+      }
+      drawList->_VtxWritePtr   = vw;
+      drawList->_IdxWritePtr   = iw;
+      drawList->_VtxCurrentIdx = base;
+      first                    = last;
+    }
+    shapes.clear();
+  }
+};
+// node shapes }}}
+
+// interaction state a node is drawn with
+struct NodeDrawState
+{
+  bool    selected        = false; // in gv.nodeSelection
+  bool    pendingSelected = false; // in the selection being built by box (de)selecting
+  bool    hovered         = false;
+  NodePin hoveredPin      = {NodePin::NONE, size_t(-1), -1};
+  NodePin activePin       = {NodePin::NONE, size_t(-1), -1};
+};
+
+// node visuals {{{
+// what drawNode() derives from a node's color, name and icon, kept per node id until the node's
+// visualStamp() changes
+
+// how a node is highlighted, in order of precedence from the last
+enum NodeLook : int
+{
+  LOOK_NORMAL,
+  LOOK_SELECTED,
+  LOOK_HOVERED,
+  LOOK_PENDING_SELECTED,
+  LOOK_COUNT
+};
+
+static NodeLook nodeLook(NodeDrawState const& state)
+{
+  return state.pendingSelected ? LOOK_PENDING_SELECTED
+         : state.hovered       ? LOOK_HOVERED
+         : state.selected      ? LOOK_SELECTED
+                               : LOOK_NORMAL;
+}
+
+struct NodeVisuals
+{
+  uint64_t stamp     = 0;
+  int      lastFrame = 0;
+
+  ImU32 fill[LOOK_COUNT];
+  ImU32 pinHot[LOOK_COUNT]; // pin under the mouse or being dragged
+  ImU32 name[LOOK_COUNT];
+  ImU32 icon[LOOK_COUNT];
+  ImU32 outline = 0; // selection highlight
+
+  std::string iconText;
+  bool        iconFromIconFont = false;
+
+  // extents scale linearly with the font size, so they are kept for a size of 1
+  struct Extent
+  {
+    ImFont* font = nullptr;
+    ImVec2  unit = {0, 0};
+  };
+  Extent iconExtent[2]; // normal & large font
+  Extent nameExtent[2];
+
+  static ImVec2 measure(Extent (&cache)[2], ImFont* font, float size, std::string const& text)
+  {
+    for (auto& e : cache)
+      if (e.font == font)
+        return e.unit * size;
+    auto& e = cache[cache[0].font ? 1 : 0];
+    e.font  = font;
+    e.unit  = font->CalcTextSizeA(font->FontSize, 8192, 0, text.c_str()) / font->FontSize;
+    return e.unit * size;
+  }
+};
+
+static std::unordered_map<size_t, NodeVisuals> nodeVisualsCache;
+
+static NodeVisuals& nodeVisuals(size_t idx, Node const& node)
+{
+  // forget nodes not drawn for a while, they may have been deleted
+  constexpr int SWEEP_FRAMES = 1024;
+  static int    lastSweep    = 0;
+  int const     frame        = ImGui::GetFrameCount();
+  if (frame - lastSweep > SWEEP_FRAMES) {
+    lastSweep = frame;
+    for (auto itr = nodeVisualsCache.begin(); itr != nodeVisualsCache.end();)
+      itr = frame - itr->second.lastFrame > SWEEP_FRAMES ? nodeVisualsCache.erase(itr) : ++itr;
+  }
+
+  auto& v     = nodeVisualsCache[idx];
+  v.lastFrame = frame;
+  if (v.stamp == node.visualStamp())
+    return v;
+
+  v           = NodeVisuals();
+  v.stamp     = node.visualStamp();
+  v.lastFrame = frame;
+
+  glm::vec4 const base              = node.color();
+  glm::vec4       color[LOOK_COUNT] = {};
+  color[LOOK_NORMAL]                = base;
+  color[LOOK_SELECTED]              = highlight(base, -0.1f, -0.4f);
+  color[LOOK_HOVERED]               = highlight(base, 0.02f, 0.3f);
+  color[LOOK_PENDING_SELECTED]      = highlight(base, 0.1f, 0.5f);
+  for (int look = 0; look < LOOK_COUNT; ++look) {
+    v.fill[look]   = imcolor(color[look]);
+    v.pinHot[look] = imcolor(highlight(color[look], 0.1f, 0.4f, 0.5f));
+    v.name[look]   = imcolor(highlight(color[look], -0.8f, 0.6f, 0.6f));
+    v.icon[look]   = imcolor(highlight(color[look], -0.8f, -0.7f, 1.0f));
+  }
+  v.outline = imcolor(highlight(base, 0.1f, 0.6f));
+  if (char const* icon = node.icon())
+    v.iconText = icon;
+  v.iconFromIconFont = !v.iconText.empty() && static_cast<unsigned char>(v.iconText[0]) == 0xEF;
+  return v;
+}
+// node visuals }}}
+
+// canvas positions drawNode() needs, appended to points: the center, then the input pins and the
+// output pins unless they are not drawn
+static void appendNodePoints(GraphGeometry const&            geo,
+                             GraphGeometry::NodeShape const& shape,
+                             std::vector<glm::vec2>&         points)
+{
+  size_t const count =
+      governor::tier() >= governor::Tier::MINIMAL ? 1 : 1 + shape.inputs + shape.outputs;
+  auto const first = geo.points.begin() + shape.firstPoint;
+  points.insert(points.end(), first, first + count);
+}
+
+// points: what appendNodePoints() gave for shape, already in screen space
+static void drawNode(ImDrawList*                     drawList,
+                     GraphView const&                gv,
+                     size_t                          idx,
+                     Node const&                     node,
+                     GraphGeometry::NodeShape const& shape,
+                     ImVec2 const*                   points,
+                     NodeDrawState const&            state)
+{
+  ImVec2 const center      = points[0];
+  auto const   canvasScale = gv.canvasScale;
+  auto const   size        = shape.size();
+  float const  pinRadius   = 4 * canvasScale;
+  int const    pinSegs     = circleSegs(pinRadius);
+  ImVec2 const topleft     = {center.x - size.x / 2.f * canvasScale,
+                              center.y - size.y / 2.f * canvasScale};
+  ImVec2 const bottomright = {center.x + size.x / 2.f * canvasScale,
+                              center.y + size.y / 2.f * canvasScale};
+
+  auto&          visuals = nodeVisuals(idx, node);
+  NodeLook const look    = nodeLook(state);
+  ImU32 const    fill    = visuals.fill[look];
+
+  static ShapeQueue shapes; // kept for its capacity
+  if (node.type() == Node::Type::NORMAL) {
+    bool const minimal = governor::tier() >= governor::Tier::MINIMAL;
+
+    {
+      NG_PROFILE_DRAW_SCOPE("drawGraph/shapes", drawList);
+      // Node itself
+      shapes.roundedRect(topleft, bottomright, fill, cornerRounding(6.f * canvasScale));
+
+      // Selected highlight
+      if (state.selected && canvasScale > 0.2) {
+        shapes.flush(drawList);
+        drawList->AddRect(topleft + ImVec2{-4 * canvasScale, -4 * canvasScale},
+                          bottomright + ImVec2{4 * canvasScale, 4 * canvasScale},
+                          visuals.outline,
+                          cornerRounding(8.f * canvasScale));
+      }
+
+      // Pins
+      if (!minimal) {
+        bool const hotPins =
+            state.hoveredPin.nodeIndex == idx || state.activePin.nodeIndex == idx;
+        auto const isHot   = [&state](NodePin const& pin) {
+          return pin == state.hoveredPin || pin == state.activePin;
+        };
+        int icount = shape.inputs;
+        if (icount < 8) {
+          for (int i = 0; i < icount; ++i) {
+            size_t upnode   = gv.graph->upstreamNodeOf(idx, i);
+            auto   pincolor = fill;
+            bool const hot      = hotPins && isHot(NodePin{NodePin::INPUT, idx, i});
+            if (upnode != -1) {
+              auto const& upvisuals = nodeVisuals(upnode, gv.graph->noderef(upnode));
+              pincolor = hot ? upvisuals.pinHot[LOOK_NORMAL] : upvisuals.fill[LOOK_NORMAL];
+            } else if (hot) {
+              pincolor = visuals.pinHot[look];
+            }
+            shapes.circle(points[1 + i], pinRadius, pincolor, pinSegs);
+          }
+        } else { // TODO: handle many pins
+          auto left = points[1];
+          auto right = points[icount];
+          shapes.roundedRect(left + ImVec2{ 6,-6 } * canvasScale, right + ImVec2{ -6,0 } * canvasScale, fill, 6);
+        }
+        for (int i = 0; i < shape.outputs; ++i) {
+          auto const currentPin = NodePin{NodePin::OUTPUT, idx, i};
+          shapes.circle(points[1 + icount + i],
+                        pinRadius,
+                        hotPins && isHot(currentPin) ? visuals.pinHot[look] : fill,
+                        pinSegs);
+        }
+      }
+      shapes.flush(drawList);
+    }
+
+    // Name & icon
+    {
+      NG_PROFILE_DRAW_SCOPE("drawGraph/text", drawList);
+      if (canvasScale >= 1.5f && globalConfig().fonts.largeFont)
+        ImGui::PushFont(globalConfig().fonts.largeFont);
+      float const fontHeight = ImGui::GetFontSize();
+      if (gv.drawName && canvasScale > 0.33 && !minimal) {
+        auto const&  name = node.displayName();
+        ImVec2 const pos  = center + ImVec2{size.x / 2.f * canvasScale + 8, -fontHeight / 2.f};
+        ImVec2 const extent =
+            NodeVisuals::measure(visuals.nameExtent, ImGui::GetFont(), fontHeight, name);
+        if (AABB<ImVec2>(drawList->GetClipRectMin(), drawList->GetClipRectMax())
+                .intersects(AABB<ImVec2>(pos, pos + extent)))
+          drawList->AddText(pos, visuals.name[look], name.data(), name.data() + name.size());
+      }
+      if (canvasScale >= 1.5f && globalConfig().fonts.largeFont)
+        ImGui::PopFont();
+
+      // Icon
+      if (!visuals.iconText.empty() && governor::tier() < governor::Tier::LOW) {
+        bool const large = canvasScale >= 1.5f && globalConfig().fonts.largeIconFont;
+        ImFont*    font  = visuals.iconFromIconFont
+                               ? (large ? globalConfig().fonts.largeIconFont
+                                        : globalConfig().fonts.stdIconFont)
+                               : (large ? globalConfig().fonts.largeFont
+                                        : globalConfig().fonts.defaultFont);
+        if (font) {
+          auto const&  icon       = visuals.iconText;
+          float const  iconHeight = size.y * canvasScale * 0.7f;
+          ImVec2 const textSize =
+              NodeVisuals::measure(visuals.iconExtent, font, iconHeight, icon);
+          drawList->AddText(font,
+                            iconHeight,
+                            center - textSize / 2,
+                            visuals.icon[look],
+                            icon.data(),
+                            icon.data() + icon.size());
+        }
+      }
+    }
+  } else if (node.type() == Node::Type::ANCHOR) {
+    shapes.circle(center, 8, fill, circleSegs(8));
+    shapes.flush(drawList);
+  }
+}
+
+// static layer {{{
+// links & nodes of a view, drawn in their resting state, are recorded and copied into the
+// window's draw list every frame, moved by whole pixels while the view pans inside the recorded
+// area; nodes which are hovered, under a pin interaction or changing selection are drawn live
+// in their place instead
+//
+// recording runs on a time budget: a huge visible set is recorded over several frames, from a
+// cursor into links & node order, and shown meanwhile as the chunks recorded so far followed by
+// the rest of the previous recording, moved & scaled to the current view
+struct StaticLayer
+{
+  struct Key
+  {
+    Graph const*    graph        = nullptr;
+    uint64_t        graphVersion = 0;
+    uint64_t        selection    = 0; // hash of gv.nodeSelection
+    float           scale        = 0;
+    NodePin         hiddenLink   = {NodePin::NONE, size_t(-1), -1}; // link being dragged
+    bool            drawName     = false;
+    ImFont*         font         = nullptr;
+    ImTextureID     texture      = nullptr;
+    ImDrawListFlags flags        = 0;
+    governor::Tier  tier         = governor::Tier::FULL;
+    float           tolerance    = 0; // linkTolerance()
+
+    // whether a recording for that can be continued for this
+    bool sameLook(Key const& that) const
+    {
+      return graph == that.graph && selection == that.selection && scale == that.scale &&
+             hiddenLink == that.hiddenLink && drawName == that.drawName && font == that.font &&
+             texture == that.texture && flags == that.flags && tier == that.tier &&
+             tolerance == that.tolerance;
+    }
+    bool operator==(Key const& that) const
+    {
+      return graphVersion == that.graphVersion && sameLook(that);
+    }
+  };
+
+  struct Segment
+  {
+    size_t   node;  // -1 for a link
+    size_t   order; // position among links or in node order
+    unsigned vtxBegin, vtxEnd;
+    unsigned idxBegin, idxEnd;
+    ImVec2   min, max; // screen bounds when recorded
+    uint64_t stamp;    // recordedStamp() when recorded, 0 for a link
+  };
+
+  struct Recording
+  {
+    Key                     key;
+    ImVec2                  origin = {0, 0}; // screen position of canvas origin
+    AABB<ImVec2>            area   = AABB<ImVec2>(ImVec2(0, 0)); // screen area covered
+    std::vector<ImDrawVert> vtx;
+    std::vector<unsigned>   idx; // into vtx, unlike ImDrawList's which restart every 64k vertices
+    std::vector<Segment>    segments;
+    std::unordered_map<size_t, size_t> nodeSegment; // node id -> index into segments
+    size_t firstNodeSegment = 0;     // segments before are links
+    uint64_t stampsUpTo     = 0;     // Node::latestVisualStamp() when started
+    size_t linkCursor       = 0;     // next link to record
+    size_t nodeCursor       = 0;     // next position in node order to record
+    bool   linksDone        = false;
+    bool   complete         = false;
+  };
+
+  Recording                   front;            // last complete recording
+  Recording                   back;             // recording in progress
+  bool                        building  = false;
+  bool                        stale     = false; // shown nodes look different than recorded
+  int                         lastFrame = -1;   // ImGui frame this view was last drawn in
+  std::unique_ptr<ImDrawList> recorder;         // back is recorded through this
+};
+
+static std::unordered_map<GraphView const*, StaticLayer> staticLayers;
+
+// least number of links & nodes recorded per frame, so that recording progresses on any machine
+static constexpr size_t STATIC_LAYER_MIN_ITEMS = 256;
+
+// links or nodes recorded between looks at the clock
+static constexpr size_t STATIC_LAYER_BATCH = 64;
+
+// maps screen positions of a recording into the current view: pos * scale + offset
+struct LayerTransform
+{
+  float  scale  = 1;
+  ImVec2 offset = {0, 0};
+  bool   exact  = true; // whole pixel move only, looks as if drawn in this view
+};
+
+static LayerTransform layerTransform(StaticLayer::Recording const& rec,
+                                     float                         scale,
+                                     ImVec2 const&                 origin)
+{
+  LayerTransform xf;
+  xf.scale  = rec.key.scale > 0 ? scale / rec.key.scale : 1.f;
+  xf.offset = origin - rec.origin * xf.scale;
+  xf.exact  = xf.scale == 1.f && std::abs(xf.offset.x - std::round(xf.offset.x)) < 1e-3f &&
+             std::abs(xf.offset.y - std::round(xf.offset.y)) < 1e-3f;
+  if (xf.exact)
+    xf.offset = ImVec2(std::round(xf.offset.x), std::round(xf.offset.y));
+  return xf;
+}
+
+// whether rec, moved by xf, covers all of area
+static bool layerCovers(StaticLayer::Recording const& rec,
+                        LayerTransform const&         xf,
+                        AABB<ImVec2> const&           area)
+{
+  return AABB<ImVec2>(rec.area.min * xf.scale + xf.offset, rec.area.max * xf.scale + xf.offset)
+      .contains(area);
+}
+
+static uint64_t selectionHash(std::set<size_t> const& selection)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t id : selection)
+    hash = (hash ^ id) * 1099511628211ull;
+  return hash ^ selection.size();
+}
+
+// recording of all views shares one budget per frame
+static double staticLayerDeadline()
+{
+  static int    frame    = -1;
+  static double deadline = 0;
+  if (frame != ImGui::GetFrameCount()) {
+    frame              = ImGui::GetFrameCount();
+    float const budget = globalConfig().drawBudgetMs;
+    deadline = budget > 0 ? profiler::now() + budget : std::numeric_limits<double>::infinity();
+  }
+  return deadline;
+}
+
+static bool staticLayerPending(Graph const& graph)
+{
+  for (auto const* view : graph.viewers()) {
+    auto itr = staticLayers.find(view);
+    if (itr != staticLayers.end() && itr->second.building &&
+        itr->second.lastFrame == ImGui::GetFrameCount())
+      return true;
+  }
+  return false;
+}
+
+// what a recorded node looks like depends on: its own visualStamp() and, as drawNode() draws
+// its first few input pins in the colors of the nodes upstream, theirs
+static uint64_t recordedStamp(Graph* graph, size_t idx, Node const& node, int inputs)
+{
+  uint64_t stamp = node.visualStamp();
+  if (inputs >= 8) // drawn as one bar in the node's own color
+    return stamp;
+  for (int i = 0; i < inputs; ++i) {
+    size_t const   upnode = graph->upstreamNodeOf(idx, i);
+    uint64_t const up     = upnode == size_t(-1) ? 0 : graph->noderef(upnode).visualStamp();
+    stamp                 = stamp * 0x100000001b3ull ^ up;
+  }
+  return stamp;
+}
+
+static void startStaticLayer(StaticLayer&             layer,
+                             StaticLayer::Key const&  key,
+                             ImVec2 const&            origin,
+                             AABB<ImVec2> const&      area)
+{
+  auto& rec  = layer.back;
+  rec.key    = key;
+  rec.origin = origin;
+  rec.area   = area;
+  rec.vtx.clear();
+  rec.idx.clear();
+  rec.segments.clear();
+  rec.nodeSegment.clear();
+  rec.firstNodeSegment = 0;
+  rec.stampsUpTo       = Node::latestVisualStamp();
+  rec.linkCursor       = 0;
+  rec.nodeCursor       = 0;
+  rec.linksDone        = false;
+  rec.complete         = false;
+
+  if (!layer.recorder)
+    layer.recorder = std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData());
+  ImDrawList* drawList = layer.recorder.get();
+  drawList->_ResetForNewFrame();
+  drawList->Flags = key.flags;
+  drawList->PushClipRect(area.min, area.max);
+  drawList->PushTextureID(key.texture);
+  layer.building = true;
+}
+
+// continues recording layer.back until deadline, sets its `complete` when all is recorded
+// links and nodes go in batches, the points of a batch are mapped to screen in one pass
+static void recordStaticLayer(StaticLayer& layer, GraphView const& gv, double deadline)
+{
+  NG_PROFILE_SCOPE("drawGraph/staticLayer/record");
+  auto&       rec      = layer.back;
+  ImDrawList* drawList = layer.recorder.get();
+  size_t      items    = 0;
+  auto const  outOfTime = [&items, deadline] {
+    bool const out = items >= STATIC_LAYER_MIN_ITEMS && profiler::now() > deadline;
+    items += STATIC_LAYER_BATCH;
+    return out;
+  };
+  auto const addSegment = [&rec, drawList](size_t node, size_t order, int vtx, int idx,
+                                           ImVec2 min, ImVec2 max, uint64_t stamp) {
+    rec.segments.push_back({node,
+                            order,
+                            unsigned(vtx),
+                            unsigned(drawList->VtxBuffer.Size),
+                            unsigned(idx),
+                            unsigned(drawList->IdxBuffer.Size),
+                            min,
+                            max,
+                            stamp});
+  };
+
+  // chunks recorded in earlier frames are in the view the recording was started in
+  glm::mat3 toScreen = gv.canvasToScreen;
+  toScreen[2][0]     = rec.origin.x;
+  toScreen[2][1]     = rec.origin.y;
+
+  std::vector<glm::vec2> canvasPoints;
+  std::vector<ImVec2>    screenPoints;
+  auto const toScreenPoints = [&] {
+    screenPoints.resize(canvasPoints.size());
+    transform(canvasPoints.data(), canvasPoints.size(), toScreen, screenPoints.data());
+  };
+
+  // culled in canvas space, so that only what is visible is transformed
+  auto const&           geo   = gv.graph->geometry();
+  float const           scale = gv.canvasScale;
+  AABB<glm::vec2> const area((glmvec(rec.area.min) - glmvec(rec.origin)) / scale,
+                             (glmvec(rec.area.max) - glmvec(rec.origin)) / scale);
+  std::vector<std::pair<size_t, size_t>> visible; // position in geo, first point
+
+  if (!rec.linksDone) {
+    NG_PROFILE_DRAW_SCOPE("drawGraph/links", drawList);
+    auto const&           links    = geo.links;
+    AABB<glm::vec2> const linkArea = area.expanded(4 / scale); // widest line
+    while (rec.linkCursor < links.size() && !outOfTime()) {
+      size_t const end = std::min(links.size(), rec.linkCursor + STATIC_LAYER_BATCH);
+      visible.clear();
+      canvasPoints.clear();
+      for (size_t i = rec.linkCursor; i < end; ++i) {
+        auto const& link = links[i];
+        if (link.bundle >= 0) {
+          // the first member brings the trunk and the bus, each one its branch, all straight
+          auto const& bundle = *geo.bundles[link.bundle];
+          if (link.branch == 0 && linkArea.intersects(AABB<glm::vec2>(bundle.min, bundle.max))) {
+            visible.emplace_back(i, canvasPoints.size());
+            canvasPoints.push_back(bundle.start);
+            canvasPoints.emplace_back(bundle.start.x, bundle.busY);
+            visible.emplace_back(i, canvasPoints.size());
+            canvasPoints.emplace_back(bundle.busMinX, bundle.busY);
+            canvasPoints.emplace_back(bundle.busMaxX, bundle.busY);
+          }
+          glm::vec2 const pin = bundle.ends[link.branch];
+          glm::vec2 const top = {pin.x, bundle.busY};
+          if (gv.pendingLink.destiny == link.input ||
+              !linkArea.intersects(AABB<glm::vec2>(glm::min(top, pin), glm::max(top, pin))))
+            continue;
+          visible.emplace_back(i, canvasPoints.size());
+          canvasPoints.push_back(top);
+          canvasPoints.push_back(pin);
+          continue;
+        }
+        if (gv.pendingLink.destiny == link.input ||
+            !linkArea.intersects(AABB<glm::vec2>(link.min, link.max)))
+          continue;
+        visible.emplace_back(i, canvasPoints.size());
+        Graph::tessellateLinkPath(gv.graph->linkPath(link.input), rec.key.tolerance, canvasPoints);
+      }
+      toScreenPoints();
+
+      for (size_t v = 0; v < visible.size(); ++v) {
+        auto const [pos, point] = visible[v];
+        size_t const  next  = v + 1 < visible.size() ? visible[v + 1].second : screenPoints.size();
+        ImVec2 const* path  = screenPoints.data() + point;
+        int           count = int(next - point);
+        ImVec2        ends[2];
+        if (rec.key.tier >= governor::Tier::LOW && count > 2) {
+          ends[0] = path[0];
+          ends[1] = path[count - 1];
+          path    = ends;
+          count   = 2;
+        }
+        auto const& source = gv.graph->noderef(links[pos].output.nodeIndex);
+        int const   vtx    = drawList->VtxBuffer.Size;
+        int const   idx    = drawList->IdxBuffer.Size;
+        drawList->AddPolyline(path,
+                              count,
+                              imcolor(highlight(source.color(), 0, 0.2f, 1.0f)),
+                              false,
+                              glm::clamp(1.f * gv.canvasScale, 1.0f, 4.0f));
+        addSegment(-1, pos, vtx, idx, rec.area.min, rec.area.max, 0);
+      }
+      rec.linkCursor = end;
+    }
+    if (rec.linkCursor >= links.size()) {
+      rec.linksDone        = true;
+      rec.firstNodeSegment = rec.segments.size();
+    }
+  }
+  if (rec.linksDone) {
+    NG_PROFILE_DRAW_SCOPE("drawGraph/nodes", drawList);
+    auto const& order = gv.graph->order();
+    while (rec.nodeCursor < order.size() && !outOfTime()) {
+      size_t const end = std::min(order.size(), rec.nodeCursor + STATIC_LAYER_BATCH);
+      visible.clear();
+      canvasPoints.clear();
+      for (size_t i = rec.nodeCursor; i < end; ++i) {
+        auto const& shape = geo.nodes[i];
+        if (!area.intersects(AABB<glm::vec2>(shape.min, shape.max)))
+          continue;
+        visible.emplace_back(i, canvasPoints.size());
+        appendNodePoints(geo, shape, canvasPoints);
+      }
+      toScreenPoints();
+
+      for (auto const& [pos, point] : visible) {
+        auto const&  shape       = geo.nodes[pos];
+        size_t const idx         = shape.id;
+        ImVec2 const center      = screenPoints[point];
+        auto const   size        = shape.size();
+        ImVec2 const topleft     = {center.x - size.x / 2.f * scale,
+                                    center.y - size.y / 2.f * scale};
+        ImVec2 const bottomright = {center.x + size.x / 2.f * scale,
+                                    center.y + size.y / 2.f * scale};
+
+        NodeDrawState state;
+        state.selected        = gv.nodeSelection.find(idx) != gv.nodeSelection.end();
+        state.pendingSelected = state.selected;
+        int const   vtx       = drawList->VtxBuffer.Size;
+        int const   ind       = drawList->IdxBuffer.Size;
+        Node const& node      = gv.graph->noderef(idx);
+        drawNode(drawList, gv, idx, node, shape, screenPoints.data() + point, state);
+        rec.nodeSegment[idx] = rec.segments.size();
+        uint64_t const stamp = recordedStamp(gv.graph, idx, node, shape.inputs);
+        addSegment(idx, pos, vtx, ind, topleft, bottomright, stamp);
+      }
+      rec.nodeCursor = end;
+    }
+    rec.complete = rec.nodeCursor >= order.size();
+  }
+
+  // take over what was recorded in this step
+  size_t const idxDone = rec.idx.size();
+  rec.vtx.insert(rec.vtx.end(),
+                 drawList->VtxBuffer.Data + rec.vtx.size(),
+                 drawList->VtxBuffer.Data + drawList->VtxBuffer.Size);
+  rec.idx.resize(drawList->IdxBuffer.Size);
+  for (auto const& cmd : drawList->CmdBuffer)
+    for (size_t i = std::max<size_t>(cmd.IdxOffset, idxDone); i < cmd.IdxOffset + cmd.ElemCount;
+         ++i)
+      rec.idx[i] = drawList->IdxBuffer[int(i)] + cmd.VtxOffset;
+}
+
+// first segment in [first, last) of rec at or after given position among links or in node order
+static size_t segmentAt(StaticLayer::Recording const& rec, size_t first, size_t last, size_t order)
+{
+  auto const begin = rec.segments.begin();
+  return std::partition_point(begin + first,
+                              begin + last,
+                              [order](StaticLayer::Segment const& seg) { return seg.order < order; }) -
+         begin;
+}
+
+// appends segments [first, last) of rec to drawList, transformed by xf
+static void emitSegments(ImDrawList*                   drawList,
+                         StaticLayer::Recording const& rec,
+                         size_t                        first,
+                         size_t                        last,
+                         LayerTransform const&         xf)
+{
+  // every PrimReserve() must stay addressable by ImDrawIdx
+  size_t const maxVertices = sizeof(ImDrawIdx) == 2 ? 0xFFFF : size_t(-1);
+  bool const   moved       = xf.scale != 1.f || xf.offset.x != 0 || xf.offset.y != 0;
+  while (first < last) {
+    unsigned const vtxBegin = rec.segments[first].vtxBegin;
+    unsigned const idxBegin = rec.segments[first].idxBegin;
+    size_t         end      = first;
+    while (end < last && rec.segments[end].vtxEnd - vtxBegin <= maxVertices)
+      ++end;
+    if (end == first) { // a single segment too large to be copied in one piece
+      ++first;
+      continue;
+    }
+    unsigned const vtxCount = rec.segments[end - 1].vtxEnd - vtxBegin;
+    unsigned const idxCount = rec.segments[end - 1].idxEnd - idxBegin;
+    if (idxCount > 0) {
+      drawList->PrimReserve(int(idxCount), int(vtxCount));
+      unsigned const base = drawList->_VtxCurrentIdx; // PrimReserve may have started a new block
+      if (moved) {
+        for (unsigned i = 0; i < vtxCount; ++i) {
+          ImDrawVert vert = rec.vtx[vtxBegin + i];
+          vert.pos        = vert.pos * xf.scale + xf.offset;
+          drawList->_VtxWritePtr[i] = vert;
+        }
+      } else {
+        memcpy(drawList->_VtxWritePtr, &rec.vtx[vtxBegin], vtxCount * sizeof(ImDrawVert));
+      }
+      for (unsigned i = 0; i < idxCount; ++i)
+        drawList->_IdxWritePtr[i] = ImDrawIdx(rec.idx[idxBegin + i] - vtxBegin + base);
+      drawList->_VtxWritePtr += vtxCount;
+      drawList->_IdxWritePtr += idxCount;
+      drawList->_VtxCurrentIdx += vtxCount;
+    }
+    first = end;
+  }
+}
+
+// emits segments [first, last) of rec, with the nodes in liveNodes drawn by drawLive in their
+// place; those are removed from liveNodes
+template<class DrawLive>
+static void emitRecording(ImDrawList*                   drawList,
+                          StaticLayer::Recording const& rec,
+                          size_t                        first,
+                          size_t                        last,
+                          LayerTransform const&         xf,
+                          std::vector<size_t>&          liveNodes,
+                          DrawLive const&               drawLive)
+{
+  std::vector<std::pair<size_t, size_t>> live; // segment, node
+  for (auto itr = liveNodes.begin(); itr != liveNodes.end();) {
+    auto seg = rec.nodeSegment.find(*itr);
+    if (seg != rec.nodeSegment.end() && seg->second >= first && seg->second < last) {
+      live.emplace_back(seg->second, *itr);
+      itr = liveNodes.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+  std::sort(live.begin(), live.end());
+  for (auto const& [seg, node] : live) {
+    emitSegments(drawList, rec, first, seg, xf);
+    drawLive(node);
+    first = seg + 1;
+  }
+  emitSegments(drawList, rec, first, last, xf);
+}
+// static layer }}}
+
 void drawGraph(GraphView const& gv, std::set<size_t> const& unconfirmedNodeSelection)
 {
+  NG_PROFILE_SCOPE("drawGraph");
   // Draw Nodes
   ImU32 const PENDING_PLACE_NODE_COLOR = IM_COL32(160, 160, 160, 64);
   ImU32 const SELECTION_BOX_COLOR      = IM_COL32(60, 110, 60, 128);
@@ -991,6 +1582,7 @@ void drawGraph(GraphView const& gv, std::set<size_t> const& unconfirmedNodeSelec
   float const GRID_SZ    = 32.0f;
   ImU32 const GRID_COLOR = IM_COL32(80, 80, 80, 40);
   if (gv.drawGrid && GRID_SZ * canvasScale >= 8.f) {
+    NG_PROFILE_DRAW_SCOPE("drawGraph/grid", drawList);
     auto gridOffset = toScreen * glm::vec3(0, 0, 1);
     for (float x = fmodf(gridOffset.x - winPos.x, GRID_SZ * canvasScale); x < canvasSize.x;
          x += GRID_SZ * canvasScale)
@@ -1008,128 +1600,167 @@ void drawGraph(GraphView const& gv, std::set<size_t> const& unconfirmedNodeSelec
     drawList->AddRectFilled(aabb.min, aabb.max, DESELECTION_BOX_COLOR);
   }
 
-  // Draw Links
-  for (auto const& link : gv.graph->links()) {
-    if (gv.pendingLink.destiny == link.first)
-      continue;
-    auto path = transform(gv.graph->linkPath(link.first), toScreen);
-    drawList->AddPolyline(
-        path.data(),
-        int(path.size()),
-        imcolor(highlight(gv.graph->noderef(link.second.nodeIndex).color(), 0, 0.2f, 1.0f)),
-        false,
-        glm::clamp(1.f * canvasScale, 1.0f, 4.0f));
-  }
-
-  // Nodes
+  // Links & Nodes
   auto visibilityClipingArea = canvasArea;
   visibilityClipingArea.expand(8 * canvasScale);
-  for (size_t i = 0; i < gv.graph->order().size(); ++i) {
-    size_t const idx         = gv.graph->order()[i];
-    auto const&  node        = gv.graph->nodes().at(idx);
-    auto const   center      = toScreen * glm::vec3(node.pos(), 1.0);
-    auto const   size        = node.size();
-    float const  pinRadius   = 4 * canvasScale;
-    int const    pinSegs     = circleSegs(pinRadius);
-    ImVec2 const topleft     = {center.x - size.x / 2.f * canvasScale,
-                                center.y - size.y / 2.f * canvasScale};
-    ImVec2 const bottomright = {center.x + size.x / 2.f * canvasScale,
-                                center.y + size.y / 2.f * canvasScale};
-
-    if (!visibilityClipingArea.intersects(AABB<ImVec2>(topleft, bottomright)))
-      continue;
-
-    auto const color = unconfirmedNodeSelection.find(idx) != unconfirmedNodeSelection.end()
-                           ? highlight(node.color(), 0.1f, 0.5f)
-                           : gv.hoveredNode == idx
-                                 ? highlight(node.color(), 0.02f, 0.3f)
-                                 : (gv.nodeSelection.find(idx) != gv.nodeSelection.end()
-                                        ? highlight(node.color(), -0.1f, -0.4f)
-                                        : node.color());
-
-    if (node.type() == Node::Type::NORMAL) {
-      // Node itself
-      drawList->AddRectFilled(
-          topleft, bottomright, imcolor(color), cornerRounding(6.f * canvasScale));
 
-      // Selected highlight
-      if (gv.nodeSelection.find(idx) != gv.nodeSelection.end() && canvasScale > 0.2)
-        drawList->AddRect(topleft + ImVec2{-4 * canvasScale, -4 * canvasScale},
-                          bottomright + ImVec2{4 * canvasScale, 4 * canvasScale},
-                          imcolor(highlight(node.color(), 0.1f, 0.6f)),
-                          cornerRounding(8.f * canvasScale));
-
-      // Pins
-      int icount = node.maxInputCount();
-      if (icount < 8) {
-        for (int i = 0; i < node.maxInputCount(); ++i) {
-          size_t upnode = gv.graph->upstreamNodeOf(idx, i);
-          auto   pincolor = color;
-          if (upnode != -1) {
-            pincolor = gv.graph->noderef(upnode).color();
-          }
-          auto const currentPin = NodePin{ NodePin::INPUT, idx, i };
-          if (currentPin == gv.hoveredPin || currentPin == gv.activePin) {
-            pincolor = highlight(pincolor, 0.1f, 0.4f, 0.5f);
-          }
-          drawList->AddCircleFilled(
-            toScreen * imvec(node.inputPinPos(i)), pinRadius, imcolor(pincolor), pinSegs);
-        }
-      } else { // TODO: handle many pins
-        auto left = node.inputPinPos(0);
-        auto right = node.inputPinPos(icount - 1);
-        drawList->AddRectFilled(toScreen * imvec(left + glm::vec2{ 6,-6 }), toScreen * imvec(right + glm::vec2{ -6,0 }), imcolor(color), 6);
-      }
-      for (int i = 0; i < node.outputCount(); ++i) {
-        auto const currentPin = NodePin{NodePin::OUTPUT, idx, i};
-        auto       pincolor   = color;
-        if (currentPin == gv.hoveredPin || currentPin == gv.activePin) {
-          pincolor = highlight(pincolor, 0.1f, 0.4f, 0.5f);
-        }
-        drawList->AddCircleFilled(
-            toScreen * imvec(node.outputPinPos(i)), pinRadius, imcolor(pincolor), pinSegs);
-      }
+  auto& layer     = staticLayers[&gv];
+  layer.lastFrame = ImGui::GetFrameCount();
+  StaticLayer::Key key;
+  key.graph        = gv.graph;
+  key.graphVersion = gv.graph->version();
+  key.selection    = selectionHash(gv.nodeSelection);
+  key.scale        = canvasScale;
+  key.hiddenLink   = gv.pendingLink.destiny;
+  key.drawName     = gv.drawName;
+  key.font         = ImGui::GetFont();
+  key.texture      = ImGui::GetIO().Fonts->TexID;
+  key.flags        = drawList->Flags;
+  key.tier         = governor::tier();
+  key.tolerance    = linkTolerance(canvasScale);
+
+  ImVec2 const origin   = toScreen * ImVec2(0, 0);
+  bool const   caching  = globalConfig().cacheStaticLayer;
+  auto const   cachedXf = layerTransform(layer.front, canvasScale, origin);
+  if (!caching || !layer.front.complete || !(layer.front.key == key) || layer.stale ||
+      !cachedXf.exact || !layerCovers(layer.front, cachedXf, visibilityClipingArea)) {
+    auto const backXf = layerTransform(layer.back, canvasScale, origin);
+    if (!caching || !layer.building || !layer.back.key.sameLook(key) || !backXf.exact ||
+        !layerCovers(layer.back, backXf, visibilityClipingArea)) {
+      // while the graph itself changes it is recorded again anyway, so only record a margin
+      // for panning when it does not
+      auto area = visibilityClipingArea;
+      if (layer.front.complete && layer.front.key.graphVersion == key.graphVersion)
+        area.expand(0.25f * std::max(canvasSize.x, canvasSize.y));
+      startStaticLayer(layer, key, origin, area);
+    }
+    recordStaticLayer(layer,
+                      gv,
+                      caching ? staticLayerDeadline() : std::numeric_limits<double>::infinity());
+    if (layer.back.complete) {
+      std::swap(layer.front, layer.back);
+      layer.building = false;
+    }
+  } else {
+    layer.building = false; // e.g. zoomed back before a recording for the other zoom finished
+  }
 
-      // Name
-      if (canvasScale >= 1.5f && globalConfig().fonts.largeFont)
-        ImGui::PushFont(globalConfig().fonts.largeFont);
-      float const fontHeight = ImGui::GetFontSize();
-      if (gv.drawName && canvasScale > 0.33) {
-        drawList->AddText(ImVec2{center.x, center.y} +
-                              ImVec2{size.x / 2.f * canvasScale + 8, -fontHeight / 2.f},
-                          imcolor(highlight(color, -0.8f, 0.6f, 0.6f)),
-                          node.displayName().c_str());
+  // what is shown: the recording, or while one is in progress its chunks so far and the rest
+  // of the last complete one; links come before nodes in either
+  struct Piece
+  {
+    StaticLayer::Recording const* rec;
+    size_t                        first, last;
+    LayerTransform                xf;
+  };
+  std::vector<Piece> pieces;
+  auto const&        front = layer.front;
+  auto const&        back  = layer.back;
+  if (!layer.building) {
+    auto const xf = layerTransform(front, canvasScale, origin);
+    pieces.push_back({&front, 0, front.firstNodeSegment, xf});
+    pieces.push_back({&front, front.firstNodeSegment, front.segments.size(), xf});
+  } else {
+    auto const backXf  = layerTransform(back, canvasScale, origin);
+    auto const frontXf = layerTransform(front, canvasScale, origin);
+    size_t const backLinks = back.linksDone ? back.firstNodeSegment : back.segments.size();
+    pieces.push_back({&back, 0, backLinks, backXf});
+    if (front.complete && !back.linksDone)
+      pieces.push_back({&front,
+                        segmentAt(front, 0, front.firstNodeSegment, back.linkCursor),
+                        front.firstNodeSegment,
+                        frontXf});
+    pieces.push_back({&back, backLinks, back.segments.size(), backXf});
+    if (front.complete)
+      pieces.push_back({&front,
+                        segmentAt(
+                            front, front.firstNodeSegment, front.segments.size(), back.nodeCursor),
+                        front.segments.size(),
+                        frontXf});
+  }
+
+  // nodes which do not look like they were recorded
+  std::vector<size_t> liveNodes;
+  std::set_symmetric_difference(gv.nodeSelection.begin(),
+                                gv.nodeSelection.end(),
+                                unconfirmedNodeSelection.begin(),
+                                unconfirmedNodeSelection.end(),
+                                std::back_inserter(liveNodes));
+  if (gv.hoveredNode != -1)
+    liveNodes.push_back(gv.hoveredNode);
+  if (gv.hoveredPin.type != NodePin::NONE)
+    liveNodes.push_back(gv.hoveredPin.nodeIndex);
+  if (gv.activePin.type != NodePin::NONE)
+    liveNodes.push_back(gv.activePin.nodeIndex);
+  // nodes recolored or renamed through the Node API, which the graph version does not see,
+  // or whose upstream nodes were, are drawn live until a recording made since replaces theirs;
+  // no node to look at while no stamp was handed out since the recordings shown were started
+  layer.stale        = false;
+  bool const changed = std::any_of(pieces.begin(), pieces.end(), [](Piece const& piece) {
+    return piece.rec->stampsUpTo < Node::latestVisualStamp();
+  });
+  for (size_t p = 0; changed && p < pieces.size(); ++p) {
+    auto const& piece = pieces[p];
+    for (size_t i = std::max(piece.first, piece.rec->firstNodeSegment); i < piece.last; ++i) {
+      auto const& seg   = piece.rec->segments[i];
+      auto        itr   = gv.graph->nodes().find(seg.node);
+      auto const* shape = gv.graph->geometry().node(seg.node);
+      if (itr != gv.graph->nodes().end() && shape &&
+          recordedStamp(gv.graph, seg.node, itr->second, shape->inputs) != seg.stamp) {
+        liveNodes.push_back(seg.node);
+        layer.stale = true;
       }
-      if (canvasScale >= 1.5f && globalConfig().fonts.largeFont)
-        ImGui::PopFont();
-
-      // Icon
-      if (char const* icon = node.icon()) {
-        if (icon[0]) {
-          ImFont* font = nullptr;
-          if (static_cast<unsigned char>(icon[0]) == 0xEF) {
-            if (canvasScale >= 1.5f && globalConfig().fonts.largeIconFont)
-              font = globalConfig().fonts.largeIconFont;
-            else
-              font = globalConfig().fonts.stdIconFont;
-          } else {
-            if (canvasScale >= 1.5f && globalConfig().fonts.largeIconFont)
-              font = globalConfig().fonts.largeFont;
-            else
-              font = globalConfig().fonts.defaultFont;
-          }
-
-          if (font) {
-            float const iconHeight = size.y * canvasScale * 0.7f;
-            auto textSize = font->CalcTextSizeA(iconHeight, 8192, 0, icon);
-            drawList->AddText(font, iconHeight, imvec(center) - textSize / 2, imcolor(highlight(color, -0.8f, -0.7f, 1.0f)), icon);
-          }
-        }
+    }
+  }
+  std::sort(liveNodes.begin(), liveNodes.end());
+  liveNodes.erase(std::unique(liveNodes.begin(), liveNodes.end()), liveNodes.end());
+
+  std::vector<glm::vec2> livePoints;
+
+  auto const drawLive = [&](size_t idx) {
+    auto const& geo   = gv.graph->geometry();
+    auto const* shape = geo.node(idx);
+    if (!shape)
+      return;
+    livePoints.clear();
+    appendNodePoints(geo, *shape, livePoints);
+    auto const points = transform(livePoints, toScreen);
+    NodeDrawState state;
+    state.selected        = gv.nodeSelection.find(idx) != gv.nodeSelection.end();
+    state.pendingSelected = unconfirmedNodeSelection.find(idx) != unconfirmedNodeSelection.end();
+    state.hovered         = gv.hoveredNode == idx;
+    state.hoveredPin      = gv.hoveredPin;
+    state.activePin       = gv.activePin;
+    drawNode(drawList, gv, idx, gv.graph->noderef(idx), *shape, points.data(), state);
+  };
+  {
+    NG_PROFILE_DRAW_SCOPE("drawGraph/staticLayer", drawList);
+    for (auto const& piece : pieces)
+      emitRecording(drawList, *piece.rec, piece.first, piece.last, piece.xf, liveNodes, drawLive);
+    for (size_t idx : liveNodes) // not recorded yet
+      drawLive(idx);
+  }
+
+  if (governor::tier() < governor::Tier::REDUCED) {
+    NG_PROFILE_DRAW_SCOPE("drawGraph/hookOverlays", drawList);
+    for (auto const& piece : pieces) {
+      for (size_t i = std::max(piece.first, piece.rec->firstNodeSegment); i < piece.last; ++i) {
+        auto const& seg = piece.rec->segments[i];
+        auto        itr = gv.graph->nodes().find(seg.node);
+        if (itr != gv.graph->nodes().end() && itr->second.type() == Node::Type::NORMAL &&
+            visibilityClipingArea.intersects(
+                AABB<ImVec2>(seg.min * piece.xf.scale + piece.xf.offset,
+                             seg.max * piece.xf.scale + piece.xf.offset)))
+          itr->second.onDraw(gv);
       }
-
-      node.onDraw(gv);
-    } else if (node.type() == Node::Type::ANCHOR) {
-      drawList->AddCircleFilled(imvec(center), 8, imcolor(color));
+    }
+    for (size_t idx : liveNodes) { // not recorded yet
+      auto const  itr   = gv.graph->nodes().find(idx);
+      auto const* shape = gv.graph->geometry().node(idx);
+      if (itr != gv.graph->nodes().end() && shape && itr->second.type() == Node::Type::NORMAL &&
+          visibilityClipingArea.intersects(
+              AABB<ImVec2>(toScreen * imvec(shape->min), toScreen * imvec(shape->max))))
+        itr->second.onDraw(gv);
     }
   }
 
@@ -1161,7 +1792,10 @@ void drawGraph(GraphView const& gv, std::set<size_t> const& unconfirmedNodeSelec
   // Pending Links ...
   auto drawLink = [&gv, drawList, &toScreen, &toCanvas](glm::vec2 const& start,
                                                        glm::vec2 const& end) {
-    auto path = transform(Graph::genLinkPath(start, end), toScreen);
+    std::vector<glm::vec2> curve;
+    Graph::tessellateLinkPath(
+        Graph::genLinkPath(start, end), linkTolerance(gv.canvasScale), curve);
+    auto const path = transform(curve, toScreen);
     drawList->AddPolyline(path.data(),
                           int(path.size()),
                           IM_COL32(233, 233, 233, 233),
@@ -1193,15 +1827,25 @@ void drawGraph(GraphView const& gv, std::set<size_t> const& unconfirmedNodeSelec
 
   // Link cutting stroke
   if (gv.uiState == GraphView::UIState::CUTING_LINK) {
-    std::vector<ImVec2> stroke(gv.linkCuttingStroke.size());
-    for (size_t i = 0; i < gv.linkCuttingStroke.size(); ++i)
-      stroke[i] = imvec(toScreen * glm::vec3(gv.linkCuttingStroke[i], 1.0f));
+    auto const stroke = transform(gv.linkCuttingStroke, toScreen);
     drawList->AddPolyline(stroke.data(), int(stroke.size()), IM_COL32(255, 0, 0, 233), false, 2);
   }
 
   if (auto hook = gv.graph->hook()) {
+    NG_PROFILE_DRAW_SCOPE("drawGraph/hookOverlays", drawList);
     hook->onGraphDraw(gv.graph, gv);
   }
+
+  // Quality tier, while lowered
+  if (governor::tier() != governor::Tier::FULL) {
+    auto const text = fmt::format("Quality: {} ({:.1f} ms, target {:.0f} ms)",
+                                  governor::tierName(governor::tier()),
+                                  governor::recentMs(),
+                                  governor::targetMs());
+    drawList->AddText(winPos + ImVec2(8, canvasSize.y - ImGui::GetFontSize() - 8),
+                      IM_COL32(255, 180, 80, 200),
+                      text.c_str());
+  }
 }
 
 void updateContextMenu(GraphView& gv)
@@ -1306,6 +1950,7 @@ static void confirmNewNodePlacing(GraphView& gv, ImVec2 const& pos)
 
 void updateNetworkView(GraphView& gv, char const* name)
 {
+  NG_PROFILE_SCOPE("updateNetworkView");
   ImGui::SetNextWindowSize(ImVec2(800, 600), ImGuiCond_FirstUseEver);
   if (!ImGui::Begin(name, gv.kind==GraphView::Kind::EVERYTHING ? nullptr : &gv.showNetwork)) {
     ImGui::End();
@@ -1320,6 +1965,11 @@ void updateNetworkView(GraphView& gv, char const* name)
       "Canvas", ImVec2(0, 0), true, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoMove);
 
   ImVec2 const canvasSize        = ImGui::GetWindowSize();
+  if (gv.needsFocus) {
+    gv.canvasSize = glm::vec2(canvasSize.x, canvasSize.y);
+    gv.needsFocus = false;
+    focusSelected(gv);
+  }
   ImVec2 const mousePos          = ImGui::GetMousePos();
   ImVec2 const winPos            = ImGui::GetCursorScreenPos();
   ImVec2 const mouseDelta        = ImGui::GetIO().MouseDelta;
@@ -1347,49 +1997,45 @@ void updateNetworkView(GraphView& gv, char const* name)
   AABB<ImVec2> selectionBox(imvec(gv.selectionBoxStart), imvec(gv.selectionBoxEnd));
 
   // Check hovering node & pin
-  for (size_t i = 0; i < graph.order().size(); ++i) {
-    size_t const idx     = graph.order()[i];
-    auto const&  node    = graph.nodes().at(idx);
-    auto const   center  = toScreen * glm::vec3(node.pos(), 1.0f);
-    auto const   size    = node.size();
-
-    ImVec2 const topleft = {center.x - size.x / 2.f * canvasScale,
-                            center.y - size.y / 2.f * canvasScale};
-
-    ImVec2 const bottomright = {center.x + size.x / 2.f * canvasScale,
-                                center.y + size.y / 2.f * canvasScale};
-
-    AABB<ImVec2> const nodebox(topleft, bottomright);
-    if (!clipArea.intersects(nodebox))
-      continue;
-
-    if (nodebox.contains(mousePos) && mouseInsideCanvas)
-      hoveredNode = idx;
-
-    if (selectionBox.intersects(nodebox)) {
-      if (gv.uiState == GraphView::UIState::BOX_SELECTING) {
-        unconfirmedNodeSelection.insert(idx);
-      } else if (gv.uiState == GraphView::UIState::BOX_DESELECTING) {
-        unconfirmedNodeSelection.erase(idx);
+  {
+    NG_PROFILE_SCOPE("updateNetworkView/hitTest");
+    auto const&     geo          = graph.geometry();
+    glm::vec2 const mouseInLocal = glmvec(toCanvas * mousePos);
+    for (auto const& shape : geo.nodes) {
+      size_t const       idx = shape.id;
+      AABB<ImVec2> const nodebox(toScreen * imvec(shape.min), toScreen * imvec(shape.max));
+      if (!clipArea.intersects(nodebox))
+        continue;
+
+      if (nodebox.contains(mousePos) && mouseInsideCanvas)
+        hoveredNode = idx;
+
+      if (selectionBox.intersects(nodebox)) {
+        if (gv.uiState == GraphView::UIState::BOX_SELECTING) {
+          unconfirmedNodeSelection.insert(idx);
+        } else if (gv.uiState == GraphView::UIState::BOX_DESELECTING) {
+          unconfirmedNodeSelection.erase(idx);
+        }
       }
-    }
 
-    if (nodebox.expanded(8 * canvasScale).contains(mousePos)) {
-      for (int ipin = 0; ipin < node.maxInputCount(); ++ipin) {
-        if (glm::distance2(node.inputPinPos(ipin),
-                           glm::xy(toCanvas * glm::vec3{mousePos.x, mousePos.y, 1})) < 25) {
-          hoveredPin = {NodePin::INPUT, idx, ipin};
+      if (nodebox.expanded(8 * canvasScale).contains(mousePos)) {
+        glm::vec2 const* pins = geo.points.data() + shape.firstPoint + 1;
+        for (int ipin = 0; ipin < shape.inputs; ++ipin) {
+          if (glm::distance2(pins[ipin], mouseInLocal) < 25) {
+            hoveredPin = {NodePin::INPUT, idx, ipin};
+          }
         }
-      }
-      for (int opin = 0; opin < node.outputCount(); ++opin) {
-        if (glm::distance2(node.outputPinPos(opin),
-                           glm::xy(toCanvas * glm::vec3{mousePos.x, mousePos.y, 1})) < 25) {
-          hoveredPin = {NodePin::OUTPUT, idx, opin};
+        for (int opin = 0; opin < shape.outputs; ++opin) {
+          if (glm::distance2(pins[shape.inputs + opin], mouseInLocal) < 25) {
+            hoveredPin = {NodePin::OUTPUT, idx, opin};
+          }
         }
       }
     }
   }
   // Mouse action - the dirty part
+  static int const mousePhase = profiler::phaseId("updateNetworkView/mouse");
+  profiler::Scope  mouseScope(mousePhase);
   if (mouseInsideCanvas && ImGui::IsWindowHovered()) {
     if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
       graph.onClicked(hoveredNode, ImGuiMouseButton_Left);
@@ -1421,27 +2067,20 @@ void updateNetworkView(GraphView& gv, char const* name)
         }
       } else {
         glm::vec2 const mouseInLocal = glmvec(toCanvas * mousePos);
-        for (auto& link : graph.links()) {
-          auto const linkStart =
-              graph.noderef(link.second.nodeIndex).outputPinPos(link.second.pinNumber);
-          auto const linkEnd =
-              graph.noderef(link.first.nodeIndex).inputPinPos(link.first.pinNumber);
-          auto const& linkPath = graph.linkPath(link.first);
-          auto linkAABB = AABB<glm::vec2>(linkStart, linkEnd);
-          for (auto const& pt : linkPath)
-            linkAABB.merge(pt);
-          if (linkAABB.expanded(12).contains(mouseInLocal)) {
+        for (auto const& link : graph.geometry().links) {
+          if (AABB<glm::vec2>(link.min, link.max).expanded(12).contains(mouseInLocal)) {
+            auto const linkPath = drawnLinkPath(graph, link);
             for (size_t i = 1; i < linkPath.size(); ++i) {
               if (pointSegmentDistance(mouseInLocal, linkPath[i - 1], linkPath[i]) <
                   5 * canvasScale) {
                 gv.uiState     = GraphView::UIState::DRAGGING_LINK_BODY;
-                gv.pendingLink = {{NodePin::OUTPUT, link.second.nodeIndex, link.second.pinNumber},
-                                  {NodePin::INPUT, link.first.nodeIndex, link.first.pinNumber}};
+                gv.pendingLink = {{NodePin::OUTPUT, link.output.nodeIndex, link.output.pinNumber},
+                                  {NodePin::INPUT, link.input.nodeIndex, link.input.pinNumber}};
                 spdlog::debug("dragging link body from node({}).pin({}) to node({}).pin({})",
-                              link.second.nodeIndex,
-                              link.second.pinNumber,
-                              link.first.nodeIndex,
-                              link.first.pinNumber);
+                              link.output.nodeIndex,
+                              link.output.pinNumber,
+                              link.input.nodeIndex,
+                              link.input.pinNumber);
                 break;
               }
             }
@@ -1682,16 +2321,14 @@ void updateNetworkView(GraphView& gv, char const* name)
       for (size_t i = 1; i < gv.linkCuttingStroke.size(); ++i) {
         cutterbox.merge(gv.linkCuttingStroke[i]);
       }
-      cutterbox.expand(100);
       std::vector<NodePin> dstPinsToDelete;
-      for (auto const& link : graph.links()) {
-        auto const linkStart = graph.noderef(link.second.nodeIndex).pos();
-        auto const linkEnd   = graph.noderef(link.first.nodeIndex).pos();
-        if (cutterbox.intersects(AABB<glm::vec2>(linkStart, linkEnd))) {
-          std::vector<glm::vec2> const& linkPath = graph.linkPath(link.first);
+      for (auto const& link : graph.geometry().links) {
+        if (cutterbox.intersects(AABB<glm::vec2>(link.min, link.max))) {
+          // cutting a trunk cuts all of its branches
+          std::vector<glm::vec2> const linkPath = drawnLinkPath(graph, link);
           if (strokeIntersects(linkPath, gv.linkCuttingStroke)) {
             dstPinsToDelete.push_back(
-                {NodePin::INPUT, link.first.nodeIndex, link.first.pinNumber});
+                {NodePin::INPUT, link.input.nodeIndex, link.input.pinNumber});
           }
         }
       }
@@ -1703,6 +2340,8 @@ void updateNetworkView(GraphView& gv, char const* name)
     gv.uiState = GraphView::UIState::VIEWING;
   }
 
+  mouseScope.end();
+
   drawGraph(gv, unconfirmedNodeSelection);
 
   updateContextMenu(gv);
@@ -1717,6 +2356,7 @@ void updateNetworkView(GraphView& gv, char const* name)
 
 void updateDatasheetView(GraphView& gv, char const* name)
 {
+  NG_PROFILE_SCOPE("updateDatasheetView");
   if (!gv.showDatasheet)
     return;
   ImGui::SetNextWindowSize(ImVec2{ 320, 480 }, ImGuiCond_FirstUseEver);
@@ -1756,9 +2396,304 @@ void updateDatasheetView(GraphView& gv, char const* name)
   ImGui::End();
 }
 
+// per-phase timings of the last frames, see profiler.h
+static void updateProfilerView(Graph& graph, bool* open)
+{
+  ImGui::SetNextWindowSize(ImVec2(720, 420), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler", open)) {
+    ImGui::End();
+    return;
+  }
+  if (ImGui::Button("Reset"))
+    profiler::reset();
+  ImGui::SameLine();
+  ImGui::Text("ms per frame over the last %d frames", profiler::HISTORY_FRAMES);
+
+  auto const                               stats = profiler::stats();
+  std::vector<profiler::PhaseStats const*> phases;
+  std::unordered_map<std::string, int64_t> vertices;
+  for (auto const& st : stats) {
+    std::string const name = st.name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".vtx") == 0)
+      vertices[name.substr(0, name.size() - 4)] = st.lastCount;
+    else if (name.find('.') == std::string::npos)
+      phases.push_back(&st);
+  }
+  // sorted by name, so that "a/b" follows "a"
+  std::sort(phases.begin(), phases.end(), [](auto const* a, auto const* b) {
+    return strcmp(a->name, b->name) < 0;
+  });
+
+  ImGui::Columns(8, "profilerColumns");
+  ImGui::SetColumnWidth(0, 220);
+  for (char const* header :
+       {"Phase", "Calls", "Last", "Min", "Mean", "P99", "Vertices", "History"}) {
+    ImGui::TextUnformatted(header);
+    ImGui::NextColumn();
+  }
+  ImGui::Separator();
+  {
+    FontScope monoscope(FontScope::MONOSPACE);
+    for (auto const* st : phases) {
+      char const* leaf  = strrchr(st->name, '/');
+      int const   depth = int(std::count(st->name, st->name + strlen(st->name), '/'));
+      ImGui::Text("%*s%s", depth * 2, "", leaf ? leaf + 1 : st->name);
+      ImGui::NextColumn();
+      ImGui::Text("%6lld", static_cast<long long>(st->lastCalls));
+      ImGui::NextColumn();
+      for (float ms : {st->lastMs, st->minMs, st->meanMs, st->p99Ms}) {
+        ImGui::Text("%8.3f", ms);
+        ImGui::NextColumn();
+      }
+      auto const vtx = vertices.find(st->name);
+      if (vtx != vertices.end())
+        ImGui::Text("%8lld", static_cast<long long>(vtx->second));
+      ImGui::NextColumn();
+      ImGui::PushID(st->name);
+      ImGui::PushItemWidth(-1);
+      ImGui::PlotLines("##history",
+                       st->history.data(),
+                       int(st->history.size()),
+                       0,
+                       nullptr,
+                       0.f,
+                       FLT_MAX,
+                       ImVec2(0, ImGui::GetTextLineHeight()));
+      ImGui::PopItemWidth();
+      ImGui::PopID();
+      ImGui::NextColumn();
+    }
+  }
+  ImGui::Columns(1);
+
+  // measured by the backend loops in entry/, see latency.h
+  if (ImGui::CollapsingHeader("Input Latency", ImGuiTreeNodeFlags_DefaultOpen)) {
+    auto const toRender  = latency::inputToRender();
+    auto const toPresent = latency::inputToPresent();
+    if (ImGui::Button("Reset##latency"))
+      latency::reset();
+    ImGui::SameLine();
+    ImGui::Text("ms from input received, over the last %zu frames with input", toPresent.samples);
+    ImGui::Columns(6, "latencyColumns");
+    ImGui::SetColumnWidth(0, 220);
+    for (char const* header : {"Until", "P50", "P90", "P99", "Max", "Last"}) {
+      ImGui::TextUnformatted(header);
+      ImGui::NextColumn();
+    }
+    ImGui::Separator();
+    {
+      FontScope monoscope(FontScope::MONOSPACE);
+      std::pair<char const*, latency::Stats const*> const rows[] = {{"rendered", &toRender},
+                                                                      {"presented", &toPresent}};
+      for (auto const& row : rows) {
+        ImGui::TextUnformatted(row.first);
+        ImGui::NextColumn();
+        auto const& st = *row.second;
+        for (float ms : {st.p50Ms, st.p90Ms, st.p99Ms, st.maxMs, st.lastMs}) {
+          ImGui::Text("%8.3f", ms);
+          ImGui::NextColumn();
+        }
+      }
+    }
+    ImGui::Columns(1);
+    auto const history = latency::history();
+    ImGui::PushItemWidth(-1);
+    ImGui::PlotLines("##latency",
+                     history.data(),
+                     int(history.size()),
+                     0,
+                     "input -> present",
+                     0.f,
+                     FLT_MAX,
+                     ImVec2(0, ImGui::GetTextLineHeight() * 3));
+    ImGui::PopItemWidth();
+  }
+
+  // hook calls, per frame history is in the "hook/..." phases above
+  if (ImGui::CollapsingHeader("Hook Calls")) {
+    bool instrumented = graph.instrumentedHook() != nullptr;
+    if (ImGui::Checkbox("Instrument hook calls", &instrumented))
+      graph.setHookInstrumented(instrumented);
+    if (auto* hook = graph.instrumentedHook()) {
+      ImGui::SameLine();
+      if (ImGui::Button("Reset##hookcalls"))
+        hook->reset();
+
+      auto methods = hook->methodStats();
+      std::sort(methods.begin(), methods.end(), [](auto const& a, auto const& b) {
+        return a.totalMs > b.totalMs;
+      });
+      FontScope monoscope(FontScope::MONOSPACE);
+      ImGui::Columns(4, "hookColumns");
+      for (char const* header : {"Method", "Calls", "Total ms", "Mean us"}) {
+        ImGui::TextUnformatted(header);
+        ImGui::NextColumn();
+      }
+      ImGui::Separator();
+      for (auto const& m : methods) {
+        ImGui::TextUnformatted(m.method);
+        ImGui::NextColumn();
+        ImGui::Text("%10lld", static_cast<long long>(m.calls));
+        ImGui::NextColumn();
+        ImGui::Text("%10.3f", m.totalMs);
+        ImGui::NextColumn();
+        ImGui::Text("%10.3f", m.totalMs * 1000.0 / m.calls);
+        ImGui::NextColumn();
+      }
+      ImGui::Columns(1);
+
+      if (ImGui::TreeNode("By Operation")) {
+        auto ops = hook->operationStats();
+        std::sort(ops.begin(), ops.end(), [](auto const& a, auto const& b) {
+          return a.totalMs > b.totalMs;
+        });
+        ImGui::Columns(4, "hookOperationColumns");
+        for (char const* header : {"Operation", "Method", "Calls", "Total ms"}) {
+          ImGui::TextUnformatted(header);
+          ImGui::NextColumn();
+        }
+        ImGui::Separator();
+        for (auto const& op : ops) {
+          ImGui::TextUnformatted(op.operation);
+          ImGui::NextColumn();
+          ImGui::TextUnformatted(op.method);
+          ImGui::NextColumn();
+          ImGui::Text("%10lld", static_cast<long long>(op.calls));
+          ImGui::NextColumn();
+          ImGui::Text("%10.3f", op.totalMs);
+          ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+        ImGui::TreePop();
+      }
+    } else if (!graph.hook()) {
+      ImGui::TextDisabled("this graph has no hook");
+    }
+  }
+  ImGui::End();
+}
+
+void setRenderOnDemand(bool enabled)
+{
+  globalConfig().renderOnDemand = enabled;
+  wakeUp();
+}
+
+bool renderOnDemand()
+{
+  return globalConfig().renderOnDemand;
+}
+
+// ImGui needs a few frames after input to settle hover states, popups and window layout
+static constexpr int SETTLE_FRAMES = 3;
+static int           settleFrames  = SETTLE_FRAMES;
+
+static bool hadInput(ImGuiIO const& io)
+{
+  if (io.MouseDelta.x != 0 || io.MouseDelta.y != 0 || io.MouseWheel != 0 ||
+      io.MouseWheelH != 0 || io.InputQueueCharacters.Size > 0)
+    return true;
+  for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); ++i)
+    if (io.MouseDown[i] || io.MouseReleased[i])
+      return true;
+  for (int i = 0; i < IM_ARRAYSIZE(io.KeysDown); ++i)
+    if (io.KeysDown[i] || io.KeysDownDurationPrev[i] >= 0) // held or just released
+      return true;
+  return false;
+}
+
+// force layouts being animated, each frame runs some ticks until they settle
+static std::unordered_map<Graph const*, std::unique_ptr<layout::ForceLayout>> forceLayouts;
+
+bool needsFrame(Graph const& graph)
+{
+  return !globalConfig().renderOnDemand || settleFrames > 0 || graph.needsFrame() ||
+         staticLayerPending(graph) || forceLayouts.count(&graph);
+}
+
+void setUndoHistoryBudget(size_t bytes)
+{
+  globalConfig().undoHistoryBudget = bytes;
+}
+
+size_t undoHistoryBudget()
+{
+  return globalConfig().undoHistoryBudget;
+}
+
+void setCacheStaticLayer(bool enabled)
+{
+  globalConfig().cacheStaticLayer = enabled;
+}
+
+bool cacheStaticLayer()
+{
+  return globalConfig().cacheStaticLayer;
+}
+
+static std::string formatBytes(size_t bytes)
+{
+  if (bytes < 1024)
+    return fmt::format("{} B", bytes);
+  if (bytes < 1024 * 1024)
+    return fmt::format("{:.1f} KB", bytes / 1024.0);
+  return fmt::format("{:.1f} MB", bytes / (1024.0 * 1024.0));
+}
+
+static void drawMemoryUsage(Graph const& graph)
+{
+  auto const memory = graph.memoryUsage();
+  auto const item   = [](char const* label, size_t bytes) {
+    std::string text = fmt::format("{} = {}", label, formatBytes(bytes));
+    ImGui::MenuItem(text.c_str(), nullptr, nullptr);
+  };
+  item("Nodes", memory.nodes);
+  item("Links", memory.links);
+  item("Link Paths", memory.linkPaths);
+  item("Node Order", memory.nodeOrder);
+  item("Views", memory.views);
+  item("Geometry", memory.geometry);
+  item("Undo History", memory.undoHistory);
+  item("Total", memory.total());
+
+  size_t const budget = undoHistoryBudget();
+  if (memory.undoHistory > budget) {
+    size_t const entries = graph.undoStack() ? graph.undoStack()->size() : 0;
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.f, 0.4f, 0.3f, 1.f));
+    ImGui::Text("Warning: undo history (%zu entries) exceeds budget of %s",
+                entries,
+                formatBytes(budget).c_str());
+    ImGui::PopStyleColor();
+  }
+  int budgetMB = int(budget >> 20);
+  if (ImGui::InputInt("Undo Budget (MB)", &budgetMB) && budgetMB > 0)
+    setUndoHistoryBudget(size_t(budgetMB) << 20);
+}
+
+// hook calls only show up in traces when instrumented, so turn that on while recording
+static bool instrumentedForTrace = false;
+static void setTraceRecording(Graph& graph, bool record)
+{
+  if (record) {
+    instrumentedForTrace = !graph.instrumentedHook();
+    if (instrumentedForTrace)
+      graph.setHookInstrumented(true);
+    trace::start();
+  } else {
+    trace::stop();
+    if (instrumentedForTrace)
+      graph.setHookInstrumented(false);
+    instrumentedForTrace = false;
+    if (size_t const dropped = trace::droppedCount())
+      spdlog::warn("trace buffers were full, {} events dropped", dropped);
+  }
+}
+
 static bool showStyleEditor = false;
+static bool showProfiler    = false;
 void updateAndDraw(GraphView& gv, char const* name, size_t id)
 {
+  NG_PROFILE_SCOPE("updateAndDraw");
   std::string focusing = "";
   if (gv.focusingNode != -1)
     focusing = fmt::format(" ({})", gv.graph->noderef(gv.focusingNode).displayName());
@@ -1877,7 +2812,76 @@ void updateAndDraw(GraphView& gv, char const* name, size_t id)
         if (auto* hook=gv.graph->hook()) {
           hook->onToolMenu(gv.graph, gv);
         }
+        if (ImGui::MenuItem(gv.nodeSelection.empty() ? "Layout Graph" : "Layout Selection")) {
+          auto const stats = layout::layered(
+              *gv.graph, gv.nodeSelection.empty() ? nullptr : &gv.nodeSelection);
+          spdlog::info("layout: {} layers, {} crossings (from {}), {:.1f} ms",
+                       stats.layers,
+                       stats.crossings,
+                       stats.crossingsBefore,
+                       stats.ms);
+        }
+        bool const forceRunning = forceLayouts.count(gv.graph) > 0;
+        // selected nodes stay pinned, the others settle around them
+        if (ImGui::MenuItem("Force Layout", nullptr, forceRunning)) {
+          if (forceRunning) {
+            gv.graph->stash();
+            forceLayouts.erase(gv.graph);
+          } else {
+            forceLayouts[gv.graph] =
+                std::make_unique<layout::ForceLayout>(*gv.graph, &gv.nodeSelection);
+          }
+        }
+        if (forceRunning) {
+          if (ImGui::MenuItem("Pin Selection", nullptr, false, !gv.nodeSelection.empty()))
+            forceLayouts[gv.graph]->pin(gv.nodeSelection, true);
+          if (ImGui::MenuItem("Unpin Selection", nullptr, false, !gv.nodeSelection.empty()))
+            forceLayouts[gv.graph]->pin(gv.nodeSelection, false);
+        }
+        ImGui::Separator();
         ImGui::MenuItem("Style Editor", nullptr, &showStyleEditor);
+        bool onDemand = renderOnDemand();
+        if (ImGui::MenuItem("Render On Demand", nullptr, &onDemand))
+          setRenderOnDemand(onDemand);
+        ImGui::MenuItem("Cache Static Layer", nullptr, &globalConfig().cacheStaticLayer);
+        if (ImGui::MenuItem("Profiler", nullptr, &showProfiler))
+          profiler::setEnabled(showProfiler);
+        ImGui::Separator();
+        bool tracing = trace::recording();
+        if (ImGui::MenuItem("Record Trace", nullptr, &tracing))
+          setTraceRecording(*gv.graph, tracing);
+        if (ImGui::MenuItem("Save Trace ...", nullptr, nullptr, !tracing && trace::eventCount())) {
+          nfdchar_t* path = nullptr;
+          auto result = NFD_SaveDialog("json", nullptr, &path);
+          if (result == NFD_OKAY && path) {
+            if (trace::write(path))
+              spdlog::info("wrote {} trace events to \"{}\"", trace::eventCount(), path);
+            else
+              spdlog::error("cannot open \"{}\" for writing", path);
+            free(path);
+          }
+        }
+        bool recordingInput = session::recording();
+        if (ImGui::MenuItem("Record Input", nullptr, &recordingInput)) {
+          if (recordingInput)
+            session::startRecording(*gv.graph);
+          else
+            session::stopRecording();
+        }
+        if (ImGui::MenuItem("Save Input Recording ...",
+                            nullptr,
+                            nullptr,
+                            !recordingInput && session::recordedFrames())) {
+          nfdchar_t* path = nullptr;
+          auto result = NFD_SaveDialog("json", nullptr, &path);
+          if (result == NFD_OKAY && path) {
+            if (session::saveRecording(path))
+              spdlog::info("wrote {} recorded frames to \"{}\"", session::recordedFrames(), path);
+            else
+              spdlog::error("cannot open \"{}\" for writing", path);
+            free(path);
+          }
+        }
         ImGui::EndMenu();
       }
       if (ImGui::BeginMenu("Help")) {
@@ -1892,6 +2896,30 @@ void updateAndDraw(GraphView& gv, char const* name, size_t id)
           ImGui::MenuItem(idxcnt.c_str(), nullptr, nullptr);
           ImGui::MenuItem(nodecnt.c_str(), nullptr, nullptr);
           ImGui::MenuItem(linkcnt.c_str(), nullptr, nullptr);
+          auto const  inputLatency = latency::inputToPresent();
+          std::string latencystr   = fmt::format("Input Latency p50 / p99 = {:.1f} / {:.1f} ms",
+                                               inputLatency.p50Ms,
+                                               inputLatency.p99Ms);
+          ImGui::MenuItem(latencystr.c_str(), nullptr, nullptr);
+          ImGui::Separator();
+          bool governed = governor::enabled();
+          if (ImGui::MenuItem("Quality Governor", nullptr, &governed))
+            governor::setEnabled(governed);
+          std::string tierstr = fmt::format("Quality Tier = {}", governor::tierName(governor::tier()));
+          ImGui::MenuItem(tierstr.c_str(), nullptr, nullptr);
+          float target = float(governor::targetMs());
+          if (ImGui::InputFloat("Target Frame (ms)", &target, 1.f, 5.f, "%.1f"))
+            governor::setTargetMs(target);
+          float& drawBudget = globalConfig().drawBudgetMs;
+          if (ImGui::InputFloat("Draw Budget (ms)", &drawBudget, 1.f, 5.f, "%.1f"))
+            drawBudget = std::max(0.f, drawBudget);
+          float& tolerance = globalConfig().linkTolerance;
+          if (ImGui::InputFloat("Link Tolerance (px)", &tolerance, 0.05f, 0.25f, "%.2f"))
+            tolerance = std::clamp(tolerance, 0.05f, 4.f);
+          ImGui::MenuItem("Build Link Paths In Background", nullptr, &globalConfig().linkPathWorker);
+          ImGui::MenuItem("Route Links Around Nodes", nullptr, &globalConfig().linkRouting);
+          ImGui::MenuItem("Bundle Links Of Busy Outputs", nullptr, &globalConfig().linkBundling);
+          drawMemoryUsage(*gv.graph);
           ImGui::EndMenu();
         }
         ImGui::EndMenu();
@@ -1929,6 +2957,20 @@ void updateAndDraw(GraphView& gv, char const* name, size_t id)
 
 void edit(Graph& graph, char const* name)
 {
+  NG_PROFILE_SCOPE("edit");
+  double const editStart = profiler::now();
+  graph.setLinkPathWorker(globalConfig().linkPathWorker);
+  graph.setLinkRouting(globalConfig().linkRouting);
+  graph.setLinkBundling(globalConfig().linkBundling);
+  graph.frameStarted();
+  if (auto itr = forceLayouts.find(&graph); itr != forceLayouts.end()) {
+    // half a frame for the layout, the rest for drawing where it got to
+    if (!itr->second->step(graph, governor::targetMs() * 0.5)) {
+      graph.stash();
+      forceLayouts.erase(itr);
+    }
+  }
+  settleFrames = hadInput(ImGui::GetIO()) ? SETTLE_FRAMES : std::max(0, settleFrames - 1);
   FontScope regularscope(FontScope::REGULAR);
   std::set<GraphView*> closedViews;
   auto viewers_cpy = graph.viewers();
@@ -1943,10 +2985,28 @@ void edit(Graph& graph, char const* name)
   }
 
   for(auto* view: closedViews) {
+    staticLayers.erase(view);
     graph.removeViewer(view);
   }
   if (showStyleEditor)
     ImGui::ShowStyleEditor();
+  // snapshots are measured once when first seen, so checking every frame stays cheap
+  static bool overBudget = false;
+  if (auto const* undoStack = graph.undoStack()) {
+    size_t const bytes = undoStack->memoryUsage();
+    if (bytes > undoHistoryBudget() && !overBudget)
+      spdlog::warn("undo history of {} entries takes {}, more than the budget of {}",
+                   undoStack->size(),
+                   formatBytes(bytes),
+                   formatBytes(undoHistoryBudget()));
+    overBudget = bytes > undoHistoryBudget();
+  }
+  if (showProfiler) {
+    updateProfilerView(graph, &showProfiler);
+    if (!showProfiler) // closed
+      profiler::setEnabled(false);
+  }
+  governor::frameTime(profiler::now() - editStart);
 }
 
 } // namespace editorui
@@ -1,9 +1,12 @@
 #pragma once
 #include "fa_icondef.h"
+#include "profiler.h"
 #include <glm/glm.hpp>
 #include <nlohmann/json_fwd.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -61,6 +64,7 @@ static constexpr glm::vec4 DEFAULT_NODE_COLOR = {0.6f, 0.6f, 0.6f, 0.8f};
 struct GraphView;
 class Node;
 class Graph;
+class InstrumentedHook;
 
 /// NodeGraphHook - this is the public interface.
 /// implement these functions to bind your own node & graph with the UI graph
@@ -113,6 +117,24 @@ public:
     return nullptr;
   }
 
+  /// creates many custom nodes at once, used by Graph::importBulk
+  /// the default implementation simply calls createNode() for each of them
+  /// @param types: node type names
+  /// @param desiredNames: desired names, same length as types
+  /// @param acceptedNames: outputs accepted names, same length as types
+  /// @param payloads: outputs created payloads, same length as types
+  virtual void createNodes(Graph* host,
+                           std::vector<std::string> const& types,
+                           std::vector<std::string> const& desiredNames,
+                           std::vector<std::string>& acceptedNames,
+                           std::vector<void*>& payloads)
+  {
+    acceptedNames.resize(types.size());
+    payloads.resize(types.size());
+    for (size_t i = 0; i < types.size(); ++i)
+      payloads[i] = createNode(host, types[i], desiredNames[i], acceptedNames[i]);
+  }
+
   /// called when trying to change a node's name
   /// @param node: the UI node hosting logical node
   /// @param desiredName: the name we want
@@ -136,6 +158,8 @@ public:
   virtual int getNodeOutputCount(Node const* node) { return 1; }
   virtual char const* getPinDescription(Node const* node, NodePin const& pin) { return nullptr; }
   virtual char const* getIcon(Node const* node) { return ICON_FA_MICROCHIP; } // icon text / use with fontawesome
+  // icons and names are measured once, call Graph::invalidateNodeVisuals() when getIcon() or
+  // getNodeSize() would answer differently for a node
 
   /// called after the default shape has been drawn
   /// you may draw some kind of overlays there
@@ -212,9 +236,27 @@ private:
   glm::vec4      color_       = DEFAULT_NODE_COLOR;
   void*          payload_     = nullptr;
   NodeGraphHook* hook_        = nullptr;
+  uint64_t       visualStamp_ = newVisualStamp();
+
+  static uint64_t newVisualStamp();
 
 public:
-  void setHook(NodeGraphHook* hook) { hook_ = hook; }
+  NodeGraphHook* hook() const { return hook_; }
+
+  void setHook(NodeGraphHook* hook)
+  {
+    hook_ = hook;
+    invalidateVisuals();
+  }
+
+  /// unique to what the node looks like: changes with its color, name, hook, and with
+  /// invalidateVisuals(); the UI keeps colors and text metrics derived from it until then
+  uint64_t visualStamp() const { return visualStamp_; }
+
+  void invalidateVisuals() { visualStamp_ = newVisualStamp(); }
+
+  /// the last visualStamp() handed out to any node: while it stays put, no node changed looks
+  static uint64_t latestVisualStamp();
 
   void setPayload(void* payload) { payload_ = payload; }
 
@@ -226,8 +268,10 @@ public:
 
   void setDisplayName(std::string name)
   {
-    if (hook_ ? hook_->onNodeNameChanged(this, displayName_, name) : true)
+    if (hook_ ? hook_->onNodeNameChanged(this, displayName_, name) : true) {
       displayName_ = std::move(name);
+      invalidateVisuals();
+    }
   }
 
   glm::vec2 pos() const { return pos_; }
@@ -243,6 +287,7 @@ public:
   void setColor(glm::vec4 const& c)
   {
     color_ = c;
+    invalidateVisuals();
     if (hook_)
       hook_->onNodeColorChanged(this, c);
   }
@@ -281,22 +326,27 @@ public:
         DEFAULT_NODE_SIZE.y);
   }
 
-  glm::vec2 inputPinPos(int i) const
+  glm::vec2 inputPinPos(int i) const { return inputPinPos(i, size(), maxInputCount()); }
+
+  glm::vec2 outputPinPos(int i) const { return outputPinPos(i, size(), outputCount()); }
+
+  /// the same, with size() and the pin count already at hand, to save calls into the hook
+  glm::vec2 inputPinPos(int i, glm::vec2 const& size, int count) const
   {
     if (type() == Type::NORMAL) {
-      return glm::vec2((size().x * 0.9f) * float(i + 1) / (maxInputCount() + 1) - size().x * 0.45f,
-                       -size().y / 2.f - 4) +
+      return glm::vec2((size.x * 0.9f) * float(i + 1) / (count + 1) - size.x * 0.45f,
+                       -size.y / 2.f - 4) +
              pos();
     } else {
       return pos();
     }
   }
 
-  glm::vec2 outputPinPos(int i) const
+  glm::vec2 outputPinPos(int i, glm::vec2 const& size, int count) const
   {
     if (type() == Type::NORMAL) {
-      return glm::vec2((size().x * 0.9f) * float(i + 1) / (outputCount() + 1) - size().x * 0.45f,
-                       size().y / 2.f + 4) +
+      return glm::vec2((size.x * 0.9f) * float(i + 1) / (count + 1) - size.x * 0.45f,
+                       size.y / 2.f + 4) +
              pos();
     } else {
       return pos();
@@ -391,10 +441,12 @@ struct GraphView
   Graph* graph = nullptr;
   size_t id = 0;
   bool   windowSetupDone = false;
+  bool   needsFocus      = false; // frame the graph on next network update (e.g. after loading)
 
   void onGraphChanged(); // callback when graph has changed
   void copy();           // copy selection to clipboard
   bool paste();          // paste content in clipboard to this graph
+  bool needsFrame() const; // in the middle of an interaction, or layout / focus pending
 };
 
 struct CommentBox
@@ -406,6 +458,43 @@ struct CommentBox
   std::string text = "";
 };
 
+/// columnar description of many nodes and links, see Graph::importBulk
+struct BulkGraphData
+{
+  struct Link
+  {
+    size_t src;    // index into the node columns below
+    int    srcPin; // output pin of src
+    size_t dst;    // index into the node columns below
+    int    dstPin; // input pin of dst
+  };
+
+  std::vector<std::string> types;     // node type names, one per node
+  std::vector<std::string> names;     // desired names, type name is used if empty
+  std::vector<glm::vec2>   positions; // node positions, {0,0} if empty
+  std::vector<glm::vec4>   colors;    // node colors, DEFAULT_NODE_COLOR if empty
+  std::vector<Link>        links;
+};
+
+/// approximate heap footprint of a graph per subsystem, in bytes, see Graph::memoryUsage()
+/// counts allocator overhead too: hash buckets, per-element nodes of hash maps & trees,
+/// JSON DOM values and malloc's own bookkeeping; payloads owned by the hook are not included
+struct MemoryUsage
+{
+  size_t nodes       = 0; // nodes_, including their names
+  size_t links       = 0; // links_
+  size_t linkPaths   = 0; // linkPathes_, including the point arrays
+  size_t nodeOrder   = 0; // nodeOrder_
+  size_t undoHistory = 0; // snapshots kept by the undo stack
+  size_t views       = 0; // GraphViews, including selections & cutting strokes
+  size_t geometry    = 0; // the shared GraphGeometry
+
+  size_t total() const
+  {
+    return nodes + links + linkPaths + nodeOrder + undoHistory + views + geometry;
+  }
+};
+
 class UndoStack
 {
 public:
@@ -413,8 +502,74 @@ public:
   virtual bool stash(Graph const& g) = 0;
   virtual bool undo(Graph& g) = 0;
   virtual bool redo(Graph& g) = 0;
+
+  /// number of entries kept and their approximate heap footprint in bytes
+  virtual size_t size() const { return 0; }
+  virtual size_t memoryUsage() const { return 0; }
+};
+
+/// links sharing an output pin, drawn as one trunk that splits into branches, see
+/// Graph::setLinkBundling(): the trunk leaves the pin downwards to a horizontal bus just above
+/// the nearest input, each branch drops from its branch point on the bus to its input pin
+struct LinkBundle
+{
+  std::vector<NodePin>   inputs;  // members, in the iteration order of Graph::links()
+  std::vector<glm::vec2> ends;    // their input pins, branch k drops from (ends[k].x, busY)
+  glm::vec2              start   = {0, 0}; // the output pin
+  float                  busY    = 0;
+  float                  busMinX = 0, busMaxX = 0;
+  glm::vec2              min     = {0, 0}; // bounds of trunk, bus & branches
+  glm::vec2              max     = {0, 0};
+
+  /// control polygon of member k, as if it was a link path of its own
+  std::vector<glm::vec2> path(size_t k) const
+  {
+    return {start, {start.x, busY}, {ends[k].x, busY}, ends[k]};
+  }
+};
+
+/// canvas space layout of all nodes & links of a graph, computed once per Graph::version() and
+/// shared by all its views, which only transform and cull it
+struct GraphGeometry
+{
+  struct NodeShape
+  {
+    size_t    id         = -1;
+    glm::vec2 min        = {0, 0}; // the node's rect
+    glm::vec2 max        = {0, 0};
+    uint32_t  firstPoint = 0; // into points: center, then input pins, then output pins
+    int       inputs     = 0; // maxInputCount()
+    int       outputs    = 0; // outputCount()
+
+    glm::vec2 size() const { return max - min; }
+  };
+  struct LinkShape
+  {
+    NodePin   input;  // key into Graph::links()
+    NodePin   output; // where it comes from
+    glm::vec2 min    = {0, 0}; // bounds of the link path, or of its path through the bundle
+    glm::vec2 max    = {0, 0};
+    int32_t   bundle = -1; // into bundles, drawn as a branch of it instead of on its own
+    uint32_t  branch = 0;  // member of the bundle
+  };
+
+  std::vector<NodeShape>             nodes;   // in Graph::order()
+  std::unordered_map<size_t, size_t> byId;    // node id -> index into nodes
+  std::vector<glm::vec2>             points;
+  std::vector<LinkShape>             links;   // in the iteration order of Graph::links()
+  std::vector<LinkBundle const*>     bundles; // while bundling is on, cached by the graph
+
+  NodeShape const* node(size_t id) const
+  {
+    auto itr = byId.find(id);
+    return itr == byId.end() ? nullptr : &nodes[itr->second];
+  }
 };
 
+class LinkPathWorker; // see Graph::setLinkPathWorker()
+struct LinkRouting;   // see Graph::setLinkRouting()
+struct LinkBundling;  // see Graph::setLinkBundling()
+
 class Graph
 {
 protected:
@@ -432,6 +587,26 @@ protected:
   NodeGraphHook*       hook_    = nullptr;
   void*                payload_ = nullptr;
   size_t               nextViewerId_ = 0;
+  std::unique_ptr<InstrumentedHook> instrumentedHook_; // wraps hook_ while hook calls are accounted
+  uint64_t             version_      = 0; // bumped on every change
+  uint64_t             drawnVersion_ = 0; // version_ when the last frame started
+  std::atomic<bool>    repaintRequested_ = {false};
+  mutable GraphGeometry geometry_;
+  mutable uint64_t      geometryVersion_ = uint64_t(-1); // version_ geometry_ was built at
+  std::unique_ptr<LinkPathWorker> linkPathWorker_; // nullptr: link paths are built in place
+  std::unique_ptr<LinkRouting>    routing_;        // nullptr: links only see their ends
+  mutable std::unique_ptr<LinkBundling> bundling_; // nullptr: links are drawn on their own
+
+  /// (re)builds the path of link dst <- src, or submits it to the worker
+  void buildLinkPath(NodePin const& dst, NodePin const& src);
+  bool installLinkPaths(); // takes finished paths from the worker, true if any was current
+  /// brings the obstacles of the router up to date with the nodes; with reroute, also rebuilds
+  /// the paths of links passing nodes that moved, resized, appeared or vanished since
+  /// returns whether any path was rebuilt, no-op without routing
+  bool syncRouting(bool reroute);
+  /// regroups the links by output pin, and rebuilds the bundles whose members changed or
+  /// whose links were built again since; called by geometry()
+  void syncBundles() const;
 
   void shiftToEnd(size_t nodeid)
   {
@@ -448,11 +623,8 @@ protected:
   }
 
 public:
-  ~Graph()
-  {
-    for (auto* v : viewers_)
-      delete v;
-  }
+  Graph();
+  ~Graph();
 
   auto const& nodes() const { return nodes_; }
   auto&       nodes() { return nodes_; }
@@ -465,9 +637,45 @@ public:
   bool undo();
   bool redo();
 
+  UndoStack const* undoStack() const { return undoStack_.get(); } // nullptr until first stash
+
+  void resetHistory(); // drops undo history, current state becomes its only entry
+
+  /// walks all containers, O(nodes + links), undo snapshots are measured once and cached
+  MemoryUsage memoryUsage() const;
+
+  /// render on demand: whether the graph changed since the last frame started, a repaint
+  /// was requested or one of the views is busy
+  bool     needsFrame() const;
+  void     frameStarted(); // called by edit()
+  uint64_t version() const { return version_; }
+
+  /// built on first use after each change, see GraphGeometry
+  GraphGeometry const& geometry() const;
+
+  /// asks for another frame, e.g. when runtime state shown by the hook changed
+  /// can be called from any thread, wakes the main loop through the wake handler
+  void requestRepaint();
+
+  /// bumps version() for changes made to nodes directly, which the graph can not see:
+  /// colors, names or anything the hook draws them from
+  void markChanged() { ++version_; }
+
+  /// for hooks whose icon or size of a node changed, see NodeGraphHook::getIcon()
+  void invalidateNodeVisuals(size_t idx)
+  {
+    nodes_.at(idx).invalidateVisuals();
+    markChanged();
+  }
+
   auto* hook() const { return hook_; }
 
-  void setHook(NodeGraphHook* hook) { hook_ = hook; }
+  void setHook(NodeGraphHook* hook);
+
+  /// routes all hook calls of this graph and its nodes through an InstrumentedHook,
+  /// which counts & times them, see instrumentedhook.h
+  void setHookInstrumented(bool instrumented);
+  InstrumentedHook* instrumentedHook() const { return instrumentedHook_.get(); }
 
   void* payload() const { return payload_; }
 
@@ -479,6 +687,7 @@ public:
 
   size_t addNode(std::string const& name, std::string const& desiredName, glm::vec2 const& pos, void* payload=nullptr)
   {
+    NG_PROFILE_SCOPE("Graph::addNode");
     size_t id = -1;
     std::string dispName = desiredName;
     void* nodepayload = payload
@@ -496,6 +705,7 @@ public:
       node.setPayload(nodepayload);
       nodes_.insert({id, node});
       nodeOrder_.push_back(id);
+      ++version_;
     }
     return id;
   }
@@ -529,6 +739,7 @@ public:
 
   void notifyViewers()
   {
+    ++version_;
     for (auto* v : viewers_)
       v->onGraphChanged();
   }
@@ -537,33 +748,67 @@ public:
                                             glm::vec2 const& end,
                                             float            avoidenceWidth = DEFAULT_NODE_SIZE.x);
 
+  /// a link path is the control polygon of its curve: every inner point is a corner, rounded
+  /// with a quadratic Bezier; appends the curve to out as a polyline that stays within tolerance
+  /// (in canvas units) of it, so pass the screen space tolerance divided by the canvas scale
+  static void tessellateLinkPath(std::vector<glm::vec2> const& controls,
+                                 float                         tolerance,
+                                 std::vector<glm::vec2>&       out);
+
   void updateLinkPath(size_t nodeidx, int ipin = -1)
   {
     if (ipin != -1) {
       auto np      = NodePin{NodePin::INPUT, nodeidx, ipin};
       auto linkitr = links_.find(np);
-      if (linkitr != links_.end()) {
-        auto const& startnode = nodes_[linkitr->second.nodeIndex];
-        auto const& endnode   = nodes_[nodeidx];
-        linkPathes_[np]       = genLinkPath(startnode.outputPinPos(linkitr->second.pinNumber),
-                                      endnode.inputPinPos(ipin),
-                                      std::min(startnode.size().x, endnode.size().x));
-      }
+      if (linkitr != links_.end())
+        buildLinkPath(np, linkitr->second);
     } else {
       for (auto itr = links_.begin(); itr != links_.end(); ++itr) {
-        if (itr->first.nodeIndex == nodeidx || itr->second.nodeIndex == nodeidx) {
-          auto const& startnode   = nodes_[itr->second.nodeIndex];
-          auto const& endnode     = nodes_[itr->first.nodeIndex];
-          linkPathes_[itr->first] = genLinkPath(startnode.outputPinPos(itr->second.pinNumber),
-                                                endnode.inputPinPos(itr->first.pinNumber),
-                                                std::min(startnode.size().x, endnode.size().x));
-        }
+        if (itr->first.nodeIndex == nodeidx || itr->second.nodeIndex == nodeidx)
+          buildLinkPath(itr->first, itr->second);
       }
     }
   }
 
+  void updateAllLinkPaths()
+  {
+    syncRouting(false);
+    // paths of links that still exist are kept, the worker uses them as placeholders
+    for (auto itr = linkPathes_.begin(); itr != linkPathes_.end();) {
+      if (links_.find(itr->first) == links_.end())
+        itr = linkPathes_.erase(itr);
+      else
+        ++itr;
+    }
+    linkPathes_.reserve(links_.size());
+    for (auto const& link : links_)
+      buildLinkPath(link.first, link.second);
+  }
+
+  /// off by default: link paths are built in place, as headless tools expect
+  /// when on, genLinkPath() runs on a worker thread and each link keeps its last path, with
+  /// the ends moved to its pins, until the new one is installed by frameStarted()
+  void setLinkPathWorker(bool enabled);
+  bool linkPathWorker() const { return !!linkPathWorker_; }
+
+  /// blocks until the worker built all submitted paths and installs them, no-op without worker
+  void finishLinkPaths();
+
+  /// off by default: genLinkPath() lays out links from their ends only, through other nodes
+  /// when on, links are routed around nodes, see linkrouter.h; when nodes change, only the
+  /// links whose paths pass them are routed again
+  void setLinkRouting(bool enabled);
+  bool linkRouting() const { return !!routing_; }
+
+  /// off by default: every link is drawn along its own path
+  /// when on, output pins feeding many inputs get a LinkBundle, cached across changes until a
+  /// member link is added, removed or built again, and their links are drawn as its branches
+  void setLinkBundling(bool enabled);
+  bool linkBundling() const { return !!bundling_; }
+
   void addLink(size_t srcnode, int srcpin, size_t dstnode, int dstpin, bool bypassHook=false)
   {
+    NG_PROFILE_SCOPE("Graph::addLink");
     if (nodes_.find(srcnode) != nodes_.end() && nodes_.find(dstnode) != nodes_.end()) {
       if ((hook_ && !bypassHook)
           ? hook_->linkCanBeAttached(&noderef(srcnode), srcpin, &noderef(dstnode), dstpin)
@@ -583,6 +828,7 @@ public:
 
   void removeLink(size_t dstnode, int dstpin, bool bypassHook=false)
   {
+    NG_PROFILE_SCOPE("Graph::removeLink");
     auto const np                = NodePin{NodePin::INPUT, dstnode, dstpin};
     auto       originalSourceItr = links_.find(NodePin{NodePin::INPUT, dstnode, dstpin});
     if (originalSourceItr != links_.end()) {
@@ -606,6 +852,7 @@ public:
 
   void removeNode(size_t idx, bool bypassHook=false)
   {
+    NG_PROFILE_SCOPE("Graph::removeNode");
     if (hook_ && !bypassHook && !hook_->nodeCanBeDeleted(&noderef(idx)))
       return;
     for (auto itr = links_.begin(); itr != links_.end();) {
@@ -635,6 +882,7 @@ public:
   template<class Container>
   void removeNodes(Container const& indices, bool bypassHook=false)
   {
+    NG_PROFILE_SCOPE("Graph::removeNodes");
     for (auto idx : indices) {
       if (hook_ && !bypassHook && !hook_->nodeCanBeDeleted(&noderef(idx)))
         continue;
@@ -665,12 +913,38 @@ public:
   template<class Container>
   void moveNodes(Container const& indices, glm::vec2 const& delta)
   {
+    NG_PROFILE_SCOPE("Graph::moveNodes");
     for (auto idx : indices) {
       auto& node = noderef(idx);
       node.setPos(node.pos() + delta);
     }
-    for (auto idx : indices) {
-      updateLinkPath(idx);
+    if (routing_) {
+      syncRouting(true); // links of the moved nodes are among those passing them
+    } else {
+      for (auto idx : indices)
+        updateLinkPath(idx);
+    }
+    notifyViewers();
+  }
+
+  /// moves each node of ids to the position at the same index, e.g. for automatic layouts
+  /// like moveNodes(), does not stash, so that callers record one undo entry per edit
+  void moveNodesTo(std::vector<size_t> const& ids, std::vector<glm::vec2> const& positions)
+  {
+    NG_PROFILE_SCOPE("Graph::moveNodesTo");
+    for (size_t i = 0; i < ids.size(); ++i)
+      noderef(ids[i]).setPos(positions[i]);
+    if (routing_) {
+      syncRouting(true);
+    } else { // one walk over the links, updateLinkPath() would walk them once per node
+      std::vector<size_t> moved(ids);
+      std::sort(moved.begin(), moved.end());
+      auto const isMoved = [&moved](size_t id) {
+        return std::binary_search(moved.begin(), moved.end(), id);
+      };
+      for (auto const& link : links_)
+        if (isMoved(link.first.nodeIndex) || isMoved(link.second.nodeIndex))
+          buildLinkPath(link.first, link.second);
     }
     notifyViewers();
   }
@@ -729,6 +1003,14 @@ public:
   bool partialSave(nlohmann::json& json, std::set<size_t> const& nodes);
   bool partialLoad(nlohmann::json const& json, std::set<size_t> *outPastedNodes=nullptr);
 
+  // create many nodes & links at once
+  // the hook gets one createNodes() call, link pathes are generated in one pass
+  // and only one history entry is recorded
+  // returns the new node id of each node in data, -1 if that node was refused by hook
+  // bypassHook skips createNodes() and the linkCanBeAttached() veto, the nodes then have
+  // neither hook nor payload, onLinkAttached() / onLinkDetached() are still called, like addLink
+  std::vector<size_t> importBulk(BulkGraphData const& data, bool bypassHook=false);
+
   bool save(nlohmann::json& section, std::string const& path) const;
   bool load(nlohmann::json const& section, std::string const& path);
 };
@@ -755,4 +1037,28 @@ void init(); // TODO: config?
 void edit(Graph& graph, char const* name);
 void deinit();
 
+/// render on demand: main loops in entry/ sleep while no frame is needed (on by default)
+void setRenderOnDemand(bool enabled);
+bool renderOnDemand();
+
+/// whether another frame is needed: recent input, graph changes, repaint requests or
+/// interactions in progress
+bool needsFrame(Graph const& graph);
+
+/// backends install a function interrupting their wait for events, any thread may call it
+void setWakeHandler(void (*wake)());
+void wakeUp();
+
+/// undo history size above which Help > Performance warns, in bytes (256 MB by default)
+void   setUndoHistoryBudget(size_t bytes);
+size_t undoHistoryBudget();
+
+/// network views replay a recording of links & nodes while nothing changed (on by default)
+/// off: everything is drawn every frame, e.g. to compare against in benchmarks
+void setCacheStaticLayer(bool enabled);
+bool cacheStaticLayer();
+
+// building blocks of edit(), exposed for benchmarks
+void updateNetworkView(GraphView& gv, char const* name);
+
 } // namespace editorui
@@ -0,0 +1,1245 @@
+#include "nodegraph.h"
+#include "instrumentedhook.h"
+#include "linkrouter.h"
+#include "tracer.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+// graph model: everything here must stay free of ImGui,
+// so that it can be linked into headless tools
+
+namespace editorui {
+
+// nodes can be built on any thread
+static std::atomic<uint64_t> lastVisualStamp{0};
+
+uint64_t Node::newVisualStamp()
+{
+  return ++lastVisualStamp;
+}
+
+uint64_t Node::latestVisualStamp()
+{
+  return lastVisualStamp.load();
+}
+
+NodeIdAllocator* NodeIdAllocator::instance_ = nullptr;
+NodeIdAllocator& NodeIdAllocator::instance()
+{
+  static std::unique_ptr<NodeIdAllocator> s_instance(new NodeIdAllocator);
+  if (instance_ == nullptr)
+    instance_ = s_instance.get();
+  return *s_instance;
+}
+
+void GraphView::onGraphChanged()
+{
+  if (graph) {
+    if (!nodeSelection.empty()) {
+      std::vector<size_t> invalidIndices;
+      for (size_t idx : nodeSelection) {
+        if (graph->nodes().find(idx) == graph->nodes().end()) {
+          invalidIndices.push_back(idx);
+        }
+      }
+      for (size_t idx : invalidIndices)
+        nodeSelection.erase(idx);
+    }
+    if (activeNode != -1 && graph->nodes().find(activeNode) != graph->nodes().end())
+      activeNode = -1;
+    if (graph->nodes().find(focusingNode) == graph->nodes().end()) {
+      if (kind == Kind::INSPECTOR)
+        showInspector = false;
+      if (kind == Kind::DATASHEET)
+        showDatasheet = false;
+    }
+  }
+}
+
+bool GraphView::needsFrame() const
+{
+  return uiState != UIState::VIEWING || needsFocus || !windowSetupDone;
+}
+
+static linkrouter::Rect bounds(std::vector<glm::vec2> const& path)
+{
+  linkrouter::Rect rect = {path.front(), path.front()};
+  for (auto const& p : path) {
+    rect.min = glm::min(rect.min, p);
+    rect.max = glm::max(rect.max, p);
+  }
+  return rect;
+}
+
+// routed around the obstacles, or laid out from the ends only if routing is off or fails
+static std::vector<glm::vec2> buildPath(glm::vec2 const&                     start,
+                                        glm::vec2 const&                     end,
+                                        float                                avoidenceWidth,
+                                        bool                                 routed,
+                                        std::vector<linkrouter::Rect> const& obstacles)
+{
+  if (routed) {
+    auto path = linkrouter::route(start, end, obstacles);
+    if (!path.empty())
+      return path;
+  }
+  return Graph::genLinkPath(start, end, avoidenceWidth);
+}
+
+// link routing {{{
+struct LinkRouting
+{
+  linkrouter::SpatialHash<size_t>  obstacles; // node rectangles by node id
+  linkrouter::SpatialHash<NodePin> corridors; // bounds of link paths by input pin
+  uint64_t                         syncedVersion = uint64_t(-1);
+  std::vector<linkrouter::Rect>    changed; // old and new rectangles of changed nodes
+  std::vector<size_t>              vanished;
+  std::unordered_set<NodePin>      reroute;
+};
+
+void Graph::setLinkRouting(bool enabled)
+{
+  if (enabled == !!routing_)
+    return;
+  if (enabled)
+    routing_.reset(new LinkRouting());
+  else
+    routing_.reset();
+  updateAllLinkPaths();
+  ++version_;
+}
+
+bool Graph::syncRouting(bool reroute)
+{
+  if (!routing_)
+    return false;
+  NG_PROFILE_SCOPE("Graph::syncRouting");
+  auto& r = *routing_;
+  r.changed.clear();
+  for (auto const& item : nodes_) {
+    glm::vec2 const        half = item.second.size() * 0.5f;
+    linkrouter::Rect const rect = {item.second.pos() - half, item.second.pos() + half};
+    linkrouter::Rect const* old = r.obstacles.find(item.first);
+    if (old && *old == rect)
+      continue;
+    if (old)
+      r.changed.push_back(*old);
+    r.changed.push_back(rect);
+    r.obstacles.insert(item.first, rect);
+  }
+  if (r.obstacles.size() > nodes_.size()) {
+    r.vanished.clear();
+    r.obstacles.forEach([&](size_t id, linkrouter::Rect const& rect) {
+      if (nodes_.find(id) == nodes_.end()) {
+        r.vanished.push_back(id);
+        r.changed.push_back(rect);
+      }
+    });
+    for (size_t id : r.vanished)
+      r.obstacles.erase(id);
+  }
+  if (!reroute || r.changed.empty())
+    return false;
+
+  // paths keep MARGIN off the nodes and reach their pins through EXTEND long stubs, so
+  // the links of a changed node and those running close by are all within this reach
+  glm::vec2 const reach = glm::vec2(linkrouter::MARGIN + linkrouter::EXTEND);
+  r.reroute.clear();
+  for (auto const& rect : r.changed) {
+    linkrouter::Rect const near = {rect.min - reach, rect.max + reach};
+    r.corridors.query(near, [&](NodePin const& dst, linkrouter::Rect const&) {
+      // the bounds of a long path are mostly empty, see whether a segment comes near
+      auto path = linkPathes_.find(dst);
+      if (path == linkPathes_.end() || path->second.size() < 2) {
+        r.reroute.insert(dst);
+        return true;
+      }
+      auto const& points = path->second;
+      for (size_t i = 1; i < points.size(); ++i) {
+        linkrouter::Rect const segment = {glm::min(points[i - 1], points[i]),
+                                          glm::max(points[i - 1], points[i])};
+        if (segment.intersects(near)) {
+          r.reroute.insert(dst);
+          break;
+        }
+      }
+      return true;
+    });
+  }
+  for (auto const& dst : r.reroute) {
+    auto itr = links_.find(dst);
+    if (itr == links_.end())
+      r.corridors.erase(dst); // link is gone
+    else
+      buildLinkPath(dst, itr->second);
+  }
+  return !r.reroute.empty();
+}
+// link routing }}}
+
+// link bundling {{{
+// output pins feeding fewer inputs keep their links drawn on their own
+static constexpr uint32_t BUNDLE_MIN_LINKS = 8;
+// the trunk goes down at least this far before the bus, branches at least this far after it
+static constexpr float BUNDLE_STUB = 16.f;
+
+struct LinkBundling
+{
+  struct Cached
+  {
+    LinkBundle bundle;
+    uint32_t   members = 0;  // matched while grouping
+    int32_t    index   = -1; // into GraphGeometry::bundles
+    bool       stale   = false;
+  };
+
+  std::unordered_map<NodePin, Cached>       bundles;  // by output pin
+  std::unordered_set<NodePin>               dirty;    // output pins of links built since last sync
+  std::unordered_map<NodePin, uint32_t>     fanout;   // links per output pin, while grouping
+  std::vector<std::pair<Cached*, uint32_t>> branches; // bundle & member of each link, if any
+};
+
+void Graph::setLinkBundling(bool enabled)
+{
+  if (enabled == !!bundling_)
+    return;
+  if (enabled)
+    bundling_.reset(new LinkBundling());
+  else
+    bundling_.reset();
+  ++version_;
+}
+
+void Graph::syncBundles() const
+{
+  NG_PROFILE_SCOPE("Graph::syncBundles");
+  auto& b = *bundling_;
+  b.fanout.clear();
+  for (auto const& link : links_)
+    ++b.fanout[link.second];
+  for (auto& item : b.bundles) {
+    item.second.members = 0;
+    item.second.stale   = b.dirty.count(item.first) > 0;
+  }
+
+  // members are kept in the order of links_, a cached bundle stays valid while it matches
+  b.branches.clear();
+  b.branches.reserve(links_.size());
+  for (auto const& link : links_) {
+    if (b.fanout[link.second] < BUNDLE_MIN_LINKS) {
+      b.branches.emplace_back(nullptr, 0);
+      continue;
+    }
+    auto& cached = b.bundles[link.second];
+    auto& inputs = cached.bundle.inputs;
+    if (cached.members >= inputs.size()) {
+      inputs.push_back(link.first);
+      cached.stale = true;
+    } else if (!(inputs[cached.members] == link.first)) {
+      inputs[cached.members] = link.first;
+      cached.stale           = true;
+    }
+    b.branches.emplace_back(&cached, cached.members++);
+  }
+
+  for (auto itr = b.bundles.begin(); itr != b.bundles.end();) {
+    auto& cached = itr->second;
+    if (cached.members == 0) { // fell below BUNDLE_MIN_LINKS, or the pin is gone
+      itr = b.bundles.erase(itr);
+      continue;
+    }
+    auto& bundle = cached.bundle;
+    if (cached.members != bundle.inputs.size()) {
+      bundle.inputs.resize(cached.members);
+      cached.stale = true;
+    }
+    if (cached.stale) {
+      bundle.start = noderef(itr->first.nodeIndex).outputPinPos(itr->first.pinNumber);
+      bundle.ends.resize(bundle.inputs.size());
+      bundle.min    = bundle.max = bundle.start;
+      float nearest = INFINITY;
+      for (size_t k = 0; k < bundle.inputs.size(); ++k) {
+        auto const& input = bundle.inputs[k];
+        bundle.ends[k]    = noderef(input.nodeIndex).inputPinPos(input.pinNumber);
+        bundle.min        = glm::min(bundle.min, bundle.ends[k]);
+        bundle.max        = glm::max(bundle.max, bundle.ends[k]);
+        nearest           = std::min(nearest, bundle.ends[k].y);
+      }
+      // inputs above or beside the output get branches going up from the stub's end
+      bundle.busY    = std::max(bundle.start.y + BUNDLE_STUB, nearest - BUNDLE_STUB);
+      bundle.busMinX = bundle.min.x;
+      bundle.busMaxX = bundle.max.x;
+      bundle.min.y   = std::min(bundle.min.y, bundle.busY);
+      bundle.max.y   = std::max(bundle.max.y, bundle.busY);
+    }
+    ++itr;
+  }
+  b.dirty.clear();
+}
+// link bundling }}}
+
+// link path worker {{{
+// jobs and results are double buffered: each side swaps a whole batch under the lock,
+// so neither the UI thread nor the worker holds it while building or installing paths
+class LinkPathWorker
+{
+public:
+  struct Job
+  {
+    NodePin                       dst;
+    glm::vec2                     start, end;
+    float                         avoidenceWidth;
+    uint64_t                      generation;
+    bool                          routed;
+    std::vector<linkrouter::Rect> obstacles; // those near the link, see linkrouter::route()
+  };
+  struct Result
+  {
+    NodePin                dst;
+    uint64_t               generation;
+    std::vector<glm::vec2> path;
+  };
+
+  LinkPathWorker() : thread_([this] { run(); }) {}
+
+  ~LinkPathWorker()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+    }
+    jobAdded_.notify_one();
+    thread_.join();
+  }
+
+  // UI thread only {{{
+  void submit(Job&& job)
+  {
+    job.generation = ++generation_;
+    latest_[job.dst] = job.generation;
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+    if (jobs_.size() == 1)
+      jobAdded_.notify_one();
+  }
+
+  /// results finished since the last call, valid until the next one
+  std::vector<Result>& takeResults()
+  {
+    taken_.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(taken_, results_);
+    hasResults_.store(false);
+    return taken_;
+  }
+
+  /// generation of the latest job submitted for dst, 0 if none is in flight
+  uint64_t latest(NodePin const& dst) const
+  {
+    auto itr = latest_.find(dst);
+    return itr == latest_.end() ? 0 : itr->second;
+  }
+  void settled(NodePin const& dst) { latest_.erase(dst); }
+  bool busy() const { return !latest_.empty(); }
+
+  void waitForResults()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    resultAdded_.wait(lock, [this] { return !results_.empty(); });
+  }
+  // UI thread only }}}
+
+  bool hasResults() const { return hasResults_.load(); }
+
+private:
+  std::mutex                            mutex_;
+  std::condition_variable               jobAdded_, resultAdded_;
+  std::vector<Job>                      jobs_;    // guarded by mutex_
+  std::vector<Result>                   results_; // guarded by mutex_
+  bool                                  quit_       = false;
+  std::atomic<bool>                     hasResults_ = {false};
+  std::vector<Result>                   taken_;  // results being installed
+  std::unordered_map<NodePin, uint64_t> latest_; // pins with paths in flight
+  uint64_t                              generation_ = 0;
+  std::thread                           thread_; // last, starts once the rest is built
+
+  void run()
+  {
+    trace::setThreadName("linkpath worker");
+    std::vector<Job>                    batch;
+    std::vector<Result>                 built;
+    std::unordered_map<NodePin, size_t> newest; // last job of each pin in the batch
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobAdded_.wait(lock, [this] { return quit_ || !jobs_.empty(); });
+        if (quit_)
+          return;
+        std::swap(batch, jobs_);
+      }
+      {
+        NG_PROFILE_SCOPE("LinkPathWorker::build");
+        // a drag resubmits the same links every frame, only the latest position counts
+        newest.clear();
+        for (size_t i = 0; i < batch.size(); ++i)
+          newest[batch[i].dst] = i;
+        for (size_t i = 0; i < batch.size(); ++i) {
+          auto const& job = batch[i];
+          if (newest[job.dst] != i)
+            continue;
+          built.push_back({job.dst,
+                           job.generation,
+                           buildPath(job.start, job.end, job.avoidenceWidth, job.routed, job.obstacles)});
+        }
+        batch.clear();
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (results_.empty())
+          std::swap(results_, built);
+        else
+          for (auto& result : built)
+            results_.push_back(std::move(result));
+        hasResults_.store(true);
+      }
+      built.clear();
+      resultAdded_.notify_all();
+      wakeUp();
+    }
+  }
+};
+
+void Graph::setLinkPathWorker(bool enabled)
+{
+  if (enabled == !!linkPathWorker_)
+    return;
+  if (enabled) {
+    linkPathWorker_.reset(new LinkPathWorker());
+  } else {
+    finishLinkPaths();
+    linkPathWorker_.reset();
+  }
+}
+
+void Graph::finishLinkPaths()
+{
+  NG_PROFILE_SCOPE("Graph::finishLinkPaths");
+  bool changed = false;
+  while (linkPathWorker_ && linkPathWorker_->busy()) {
+    linkPathWorker_->waitForResults();
+    changed |= installLinkPaths();
+  }
+  if (changed)
+    ++version_;
+}
+
+bool Graph::installLinkPaths()
+{
+  NG_PROFILE_SCOPE("Graph::installLinkPaths");
+  bool installed = false;
+  for (auto& result : linkPathWorker_->takeResults()) {
+    // paths of links since rebuilt or removed are dropped
+    if (result.generation != linkPathWorker_->latest(result.dst))
+      continue;
+    linkPathWorker_->settled(result.dst);
+    if (links_.find(result.dst) == links_.end())
+      continue;
+    auto& path = linkPathes_[result.dst] = std::move(result.path);
+    if (routing_)
+      routing_->corridors.insert(result.dst, bounds(path));
+    installed = true;
+  }
+  return installed;
+}
+
+void Graph::buildLinkPath(NodePin const& dst, NodePin const& src)
+{
+  auto const&    startnode = noderef(src.nodeIndex);
+  auto const&    endnode   = noderef(dst.nodeIndex);
+  LinkPathWorker::Job job;
+  job.dst            = dst;
+  job.start          = startnode.outputPinPos(src.pinNumber);
+  job.end            = endnode.inputPinPos(dst.pinNumber);
+  job.avoidenceWidth = std::min(startnode.size().x, endnode.size().x);
+  job.routed         = !!routing_;
+  if (routing_)
+    job.routed = routing_->obstacles.query(
+        linkrouter::searchArea(job.start, job.end), [&](size_t, linkrouter::Rect const& r) {
+          job.obstacles.push_back(r);
+          return job.obstacles.size() <= linkrouter::MAX_OBSTACLES;
+        });
+  if (!job.routed)
+    job.obstacles.clear();
+
+  auto& path = linkPathes_[dst];
+  if (!linkPathWorker_) {
+    path = buildPath(job.start, job.end, job.avoidenceWidth, job.routed, job.obstacles);
+  } else if (path.size() < 2) {
+    path = {job.start, job.end};
+  } else {
+    // until the new path arrives, the ends of the last one follow the pins, along with the
+    // corners next to them, so that the stubs leaving the pins stay straight
+    glm::vec2 const startDelta = job.start - path.front();
+    glm::vec2 const endDelta   = job.end - path.back();
+    if (path.size() > 3) {
+      path[1] += startDelta;
+      path[path.size() - 2] += endDelta;
+    }
+    path.front() = job.start;
+    path.back()  = job.end;
+  }
+  if (routing_) // the placeholder's, for now, so that changes nearby find the link
+    routing_->corridors.insert(dst, bounds(path));
+  if (bundling_) // one of its ends moved, or it is new
+    bundling_->dirty.insert(src);
+  if (linkPathWorker_)
+    linkPathWorker_->submit(std::move(job));
+}
+// link path worker }}}
+
+// render on demand {{{
+static std::atomic<void (*)()> wakeHandler = {nullptr};
+
+void setWakeHandler(void (*wake)())
+{
+  wakeHandler.store(wake);
+}
+
+void wakeUp()
+{
+  if (auto* wake = wakeHandler.load())
+    wake();
+}
+
+bool Graph::needsFrame() const
+{
+  if (version_ != drawnVersion_ || repaintRequested_.load())
+    return true;
+  if (linkPathWorker_ && linkPathWorker_->hasResults())
+    return true;
+  for (auto const* view : viewers_)
+    if (view->needsFrame())
+      return true;
+  return false;
+}
+
+void Graph::frameStarted()
+{
+  if (repaintRequested_.exchange(false))
+    ++version_; // whatever the hook shows has changed, cached drawings are stale
+  if (linkPathWorker_ && linkPathWorker_->hasResults() && installLinkPaths())
+    ++version_;
+  if (routing_ && routing_->syncedVersion != version_) { // catches nodes added, removed or resized
+    if (syncRouting(true))
+      ++version_;
+    routing_->syncedVersion = version_;
+  }
+  drawnVersion_ = version_;
+}
+
+void Graph::requestRepaint()
+{
+  repaintRequested_.store(true);
+  wakeUp();
+}
+// render on demand }}}
+
+// geometry {{{
+GraphGeometry const& Graph::geometry() const
+{
+  if (geometryVersion_ == version_)
+    return geometry_;
+  NG_PROFILE_SCOPE("Graph::geometry");
+  auto& geo = geometry_;
+  geo.nodes.clear();
+  geo.byId.clear();
+  geo.points.clear();
+  geo.links.clear();
+
+  geo.nodes.reserve(nodeOrder_.size());
+  geo.byId.reserve(nodeOrder_.size());
+  for (size_t id : nodeOrder_) {
+    auto const&     node = nodes_.at(id);
+    glm::vec2 const size = node.size();
+    glm::vec2 const pos  = node.pos();
+
+    GraphGeometry::NodeShape shape;
+    shape.id         = id;
+    shape.min        = pos - size * 0.5f;
+    shape.max        = pos + size * 0.5f;
+    shape.firstPoint = uint32_t(geo.points.size());
+    shape.inputs     = node.maxInputCount();
+    shape.outputs    = node.outputCount();
+    geo.points.push_back(pos);
+    for (int i = 0; i < shape.inputs; ++i)
+      geo.points.push_back(node.inputPinPos(i, size, shape.inputs));
+    for (int i = 0; i < shape.outputs; ++i)
+      geo.points.push_back(node.outputPinPos(i, size, shape.outputs));
+    geo.byId[id] = geo.nodes.size();
+    geo.nodes.push_back(shape);
+  }
+
+  geo.bundles.clear();
+  if (bundling_) {
+    syncBundles();
+    for (auto& item : bundling_->bundles) {
+      item.second.index = int32_t(geo.bundles.size());
+      geo.bundles.push_back(&item.second.bundle);
+    }
+  }
+
+  geo.links.reserve(links_.size());
+  size_t position = 0;
+  for (auto const& link : links_) {
+    GraphGeometry::LinkShape shape{link.first, link.second};
+    auto const* branch = bundling_ ? &bundling_->branches[position++] : nullptr;
+    if (branch && branch->first) {
+      auto const& bundle = branch->first->bundle;
+      shape.bundle       = branch->first->index;
+      shape.branch       = branch->second;
+      shape.min = glm::min(bundle.start, glm::vec2(bundle.ends[shape.branch].x, bundle.busY));
+      shape.max = glm::max(bundle.start, glm::vec2(bundle.ends[shape.branch].x, bundle.busY));
+      shape.min = glm::min(shape.min, bundle.ends[shape.branch]);
+      shape.max = glm::max(shape.max, bundle.ends[shape.branch]);
+      geo.links.push_back(shape);
+      continue;
+    }
+    auto const& path = linkPathes_.at(link.first);
+    if (!path.empty())
+      shape.min = shape.max = path.front();
+    for (auto const& pt : path) {
+      shape.min = glm::min(shape.min, pt);
+      shape.max = glm::max(shape.max, pt);
+    }
+    geo.links.push_back(shape);
+  }
+
+  geometryVersion_ = version_;
+  return geo;
+}
+// geometry }}}
+
+// memory accounting {{{
+// estimates assume a typical 64 bit malloc: 8 bytes header per block, 16 bytes granularity,
+// 32 bytes minimum, and libstdc++ container layouts
+static size_t heapBlockBytes(size_t bytes)
+{
+  return bytes ? std::max<size_t>(32, (bytes + sizeof(size_t) + 15) & ~size_t(15)) : 0;
+}
+
+static size_t stringBytes(std::string const& str)
+{
+  return str.capacity() > 15 ? heapBlockBytes(str.capacity() + 1) : 0; // short strings are inline
+}
+
+template<class T>
+static size_t vectorBytes(std::vector<T> const& vec)
+{
+  return heapBlockBytes(vec.capacity() * sizeof(T));
+}
+
+// bucket array + one heap node per element: next pointer, cached hash and the value
+template<class K, class V>
+static size_t hashMapBytes(std::unordered_map<K, V> const& map)
+{
+  return heapBlockBytes(map.bucket_count() * sizeof(void*)) +
+         map.size() * heapBlockBytes(2 * sizeof(void*) + sizeof(std::pair<K const, V>));
+}
+
+// one red-black tree node per element: color, parent, left, right and the value
+static size_t treeNodeBytes(size_t valueBytes)
+{
+  return heapBlockBytes(4 * sizeof(void*) + valueBytes);
+}
+
+// heap owned by a json value, the value itself is counted by its container
+static size_t jsonBytes(nlohmann::json const& js)
+{
+  size_t bytes = 0;
+  switch (js.type()) {
+  case nlohmann::json::value_t::object: {
+    auto const& object = *js.get_ptr<nlohmann::json::object_t const*>();
+    bytes += heapBlockBytes(sizeof(object));
+    for (auto const& item : object)
+      bytes += treeNodeBytes(sizeof(item)) + stringBytes(item.first) +
+               jsonBytes(item.second);
+    break;
+  }
+  case nlohmann::json::value_t::array: {
+    auto const& array = *js.get_ptr<nlohmann::json::array_t const*>();
+    bytes += heapBlockBytes(sizeof(array)) + vectorBytes(array);
+    for (auto const& item : array)
+      bytes += jsonBytes(item);
+    break;
+  }
+  case nlohmann::json::value_t::string: {
+    auto const& str = *js.get_ptr<nlohmann::json::string_t const*>();
+    bytes += heapBlockBytes(sizeof(str)) + stringBytes(str);
+    break;
+  }
+  case nlohmann::json::value_t::binary: {
+    auto const& binary = *js.get_ptr<nlohmann::json::binary_t const*>();
+    bytes += heapBlockBytes(sizeof(binary)) + vectorBytes(binary);
+    break;
+  }
+  default: // numbers, booleans and null live inside the value
+    break;
+  }
+  return bytes;
+}
+
+MemoryUsage Graph::memoryUsage() const
+{
+  MemoryUsage usage;
+  usage.nodes = hashMapBytes(nodes_);
+  for (auto const& n : nodes_)
+    usage.nodes += stringBytes(n.second.initialName()) + stringBytes(n.second.displayName());
+  usage.links     = hashMapBytes(links_);
+  usage.linkPaths = hashMapBytes(linkPathes_);
+  for (auto const& path : linkPathes_)
+    usage.linkPaths += vectorBytes(path.second);
+  usage.nodeOrder   = vectorBytes(nodeOrder_);
+  usage.undoHistory = undoStack_ ? undoStack_->memoryUsage() : 0;
+  usage.views       = vectorBytes(viewers_);
+  usage.geometry    = vectorBytes(geometry_.nodes) + hashMapBytes(geometry_.byId) +
+                     vectorBytes(geometry_.points) + vectorBytes(geometry_.links) +
+                     vectorBytes(geometry_.bundles);
+  if (bundling_) {
+    usage.geometry += hashMapBytes(bundling_->bundles) + hashMapBytes(bundling_->fanout) +
+                      vectorBytes(bundling_->branches);
+    for (auto const& item : bundling_->bundles)
+      usage.geometry += vectorBytes(item.second.bundle.inputs) +
+                        vectorBytes(item.second.bundle.ends);
+  }
+  for (auto const* view : viewers_) {
+    usage.views += heapBlockBytes(sizeof(GraphView)) + vectorBytes(view->linkCuttingStroke) +
+                   stringBytes(view->pendingNodeClass) +
+                   view->nodeSelection.size() * treeNodeBytes(sizeof(size_t));
+  }
+  return usage;
+}
+// memory accounting }}}
+
+// TODO: too naive, refactor this
+class UndoStackImpl : public UndoStack
+{
+  std::vector<nlohmann::json> history_;
+  ptrdiff_t                   cursor_=-1;
+  mutable std::vector<size_t> bytes_; // footprint of each snapshot, 0 until measured
+
+public:
+  bool stash(Graph const& g) override
+  {
+    if (cursor_ + 1 < ptrdiff_t(history_.size())) // 0 reserved
+      history_.resize(cursor_ + 1);
+    bytes_.resize(std::min(bytes_.size(), history_.size()));
+    if (g.save(history_.emplace_back(), "")) {
+      ++cursor_;
+      return true;
+    }
+    return false;
+  }
+  size_t size() const override { return history_.size(); }
+  size_t memoryUsage() const override
+  {
+    // snapshots never change once taken, so each is walked only once
+    bytes_.resize(history_.size(), 0);
+    size_t total = vectorBytes(history_) + vectorBytes(bytes_);
+    for (size_t i = 0; i < history_.size(); ++i) {
+      if (!bytes_[i])
+        bytes_[i] = jsonBytes(history_[i]);
+      total += bytes_[i];
+    }
+    return total;
+  }
+  bool undo(Graph& g) override
+  {
+    if (history_.empty() || cursor_ < 1)
+      return false;
+    --cursor_;
+    assert(cursor_<history_.size());
+    return g.load(history_[cursor_], "");
+  }
+  bool redo(Graph& g) override
+  {
+    if (history_.empty() || cursor_ + 1 >= ptrdiff_t(history_.size()))
+      return false;
+    ++cursor_;
+    return g.load(history_[cursor_], "");
+  }
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(glm::vec4, x, y, z, w);
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(glm::vec3, x, y, z);
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(glm::vec2, x, y);
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NodePin, type, nodeIndex, pinNumber);
+
+std::vector<glm::vec2> Graph::genLinkPath(glm::vec2 const& start,
+                                          glm::vec2 const& end,
+                                          float            avoidenceWidth)
+{
+  std::vector<glm::vec2> path;
+  const float LOOP_CORNER_SIZE = 8.f;
+  const float EXTEND = 16.f;
+
+  float xcenter  = (start.x + end.x) * 0.5f;
+  float ycenter  = (start.y + end.y) * 0.5f;
+  float const dx = end.x - start.x;
+  float const dy = end.y - start.y;
+  auto  sign     = [](float x) { return x > 0 ? 1 : x < 0 ? -1 : 0; };
+
+  if (dy < EXTEND*2 + LOOP_CORNER_SIZE*2) {
+    if (fabs(dx)<=fabs(dy)*2) {
+      // xcenter += sign(dx) * avoidenceWidth;
+      xcenter = start.x - sign(dx) * avoidenceWidth;
+    }
+    auto endextend = end + glm::vec2(0, -EXTEND);
+    float const restdy = dy - EXTEND*2;
+
+    path.push_back(start);
+    path.push_back(start + glm::vec2(0, EXTEND));
+    if (fabs(dx) > fabs(restdy)*2 + LOOP_CORNER_SIZE * 8) {
+      path.emplace_back(start.x + sign(dx) * LOOP_CORNER_SIZE, path.back().y + LOOP_CORNER_SIZE);
+      path.emplace_back(xcenter - sign(dx * restdy) * restdy / 2 - sign(dx) * LOOP_CORNER_SIZE, path.back().y);
+      path.emplace_back(xcenter + sign(dx * restdy) * restdy / 2 + sign(dx) * LOOP_CORNER_SIZE, endextend.y - LOOP_CORNER_SIZE);
+      path.emplace_back(end.x - sign(dx) * LOOP_CORNER_SIZE, endextend.y - LOOP_CORNER_SIZE);
+    } else if (restdy < 0) {
+      path.emplace_back(start.x + sign(xcenter - start.x) * LOOP_CORNER_SIZE, start.y + EXTEND + LOOP_CORNER_SIZE);
+      path.emplace_back(xcenter - sign(xcenter - start.x) * LOOP_CORNER_SIZE, path.back().y);
+      path.emplace_back(xcenter, path.back().y - LOOP_CORNER_SIZE);
+      path.emplace_back(xcenter, endextend.y);
+      path.emplace_back(xcenter + sign(end.x - xcenter) * LOOP_CORNER_SIZE, endextend.y - LOOP_CORNER_SIZE);
+      path.emplace_back(end.x - sign(end.x - xcenter) * LOOP_CORNER_SIZE, end.y - EXTEND - LOOP_CORNER_SIZE);
+    }
+    path.push_back(endextend);
+    path.push_back(end);
+  } else {
+    path.push_back(start);
+    if (fabs(dx) >= 0.33f) {
+      if (dy > fabs(dx) + 42) {
+        if (dy < 80) {
+          path.emplace_back(start.x, ycenter - fabs(dx) / 2);
+          path.emplace_back(end.x, ycenter + fabs(dx) / 2);
+        } else {
+          path.emplace_back(start.x, end.y - fabs(dx) - 20);
+          path.emplace_back(end.x, end.y - 20);
+        }
+      } else if (dy>40) {
+        path.emplace_back(start.x, start.y + 20);
+        if (dy < fabs(dx) + 40) {
+          path.emplace_back(start.x + sign(dx) * (dy - 40) / 2, ycenter);
+          path.emplace_back(end.x - sign(dx) * (dy - 40) / 2, ycenter);
+        }
+        path.emplace_back(end.x, end.y - 20);
+      }
+    }
+    path.push_back(end);
+  }
+  return path;
+}
+
+void Graph::tessellateLinkPath(std::vector<glm::vec2> const& controls,
+                               float                         tolerance,
+                               std::vector<glm::vec2>&       out)
+{
+  // corners of genLinkPath() are about this far apart, larger radii get cut to half a side
+  const float CORNER_RADIUS   = 12.f;
+  const int   MAX_CORNER_SEGS = 16;
+
+  size_t const n = controls.size();
+  if (n < 3) {
+    out.insert(out.end(), controls.begin(), controls.end());
+    return;
+  }
+  tolerance = std::max(tolerance, 1e-3f);
+  size_t const first = out.size();
+  // points closer than tolerance to the last one add nothing visible
+  auto const emit = [&out, first, tolerance](glm::vec2 const& p) {
+    if (out.size() > first) {
+      glm::vec2 const d = p - out.back();
+      if (glm::dot(d, d) < tolerance * tolerance)
+        return;
+    }
+    out.push_back(p);
+  };
+
+  out.push_back(controls.front());
+  for (size_t i = 1; i + 1 < n; ++i) {
+    glm::vec2 const corner = controls[i];
+    glm::vec2 const in     = controls[i - 1] - corner;
+    glm::vec2 const outd   = controls[i + 1] - corner;
+    float const     lin    = glm::length(in);
+    float const     lout   = glm::length(outd);
+    float const     radius = std::min({CORNER_RADIUS, lin / 2, lout / 2});
+    if (radius <= 0) // repeated point
+      continue;
+    glm::vec2 const a = corner + in * (radius / lin);
+    glm::vec2 const b = corner + outd * (radius / lout);
+    // a polyline of k even steps along a quadratic Bezier is off by at most |a - 2c + b| / 4k^2
+    float const bend = glm::length(a - 2.f * corner + b);
+    int const   k =
+        std::min(MAX_CORNER_SEGS, int(std::ceil(std::sqrt(bend / (4 * tolerance)))));
+    emit(a);
+    for (int s = 1; s < k; ++s) {
+      float const t = float(s) / k;
+      emit((1 - t) * (1 - t) * a + 2 * (1 - t) * t * corner + t * t * b);
+    }
+    emit(b);
+  }
+  // the end point is where the pin is, keep it exact
+  if (out.size() > first + 1) {
+    glm::vec2 const d = controls.back() - out.back();
+    if (glm::dot(d, d) < tolerance * tolerance)
+      out.pop_back();
+  }
+  out.push_back(controls.back());
+}
+
+
+Graph::Graph() = default;
+
+Graph::~Graph()
+{
+  for (auto* v : viewers_)
+    delete v;
+}
+
+void Graph::setHook(NodeGraphHook* hook)
+{
+  instrumentedHook_.reset();
+  hook_ = hook;
+}
+
+void Graph::setHookInstrumented(bool instrumented)
+{
+  if (instrumented == !!instrumentedHook_ || !hook_)
+    return;
+  NodeGraphHook* const from = hook_;
+  if (instrumented) {
+    instrumentedHook_ = std::make_unique<InstrumentedHook>(hook_);
+    hook_             = instrumentedHook_.get();
+  } else {
+    hook_ = instrumentedHook_->inner();
+  }
+  for (auto& n : nodes_)
+    if (n.second.hook_ == from)
+      n.second.hook_ = hook_;
+  if (!instrumented)
+    instrumentedHook_.reset();
+}
+
+bool Graph::partialSave(nlohmann::json& json, std::set<size_t> const& nodes)
+{
+  NG_PROFILE_SCOPE("Graph::partialSave");
+  auto& uigraph = json["uigraph"];
+  auto& nodesection = uigraph["nodes"];
+  for (size_t id : nodes) {
+    auto const& node = noderef(id);
+    nlohmann::json nodedef;
+    nodedef["id"] = id;
+    nodedef["initialName"] = node.initialName();
+    nodedef["displayName"] = node.displayName();
+    nodedef["minInputs"] = node.minInputCount();
+    nodedef["maxInputs"] = node.maxInputCount();
+    nodedef["nOutputs"] = node.outputCount();
+    to_json(nodedef["color"], node.color());
+    to_json(nodedef["pos"], node.pos());
+    nodesection.push_back(nodedef);
+  }
+  auto& linksection = uigraph["links"];
+  for (auto const& link : links_) {
+    if (nodes.find(link.first.nodeIndex) != nodes.end()/* || nodes.find(link.second.nodeIndex) != nodes.end()*/) {
+      nlohmann::json linkdef;
+      linkdef["from"] = link.second;
+      linkdef["fromname"] = noderef(link.second.nodeIndex).displayName();
+      linkdef["to"] = link.first;
+      linksection.push_back(linkdef);
+    }
+  }
+  if (hook_)
+    return hook_->onPartialSave(this, json, nodes);
+  return true;
+}
+
+bool Graph::partialLoad(nlohmann::json const& json, std::set<size_t> *outPastedNodes)
+{
+  NG_PROFILE_SCOPE("Graph::partialLoad");
+  if (!json.is_object() || json.find("uigraph") == json.end())
+    return false;
+  auto const& uigraph = json["uigraph"];
+  std::unordered_map<size_t, size_t> idMap;
+  for (auto const& nodedef: uigraph["nodes"]) {
+    glm::vec2 pos;
+    from_json(nodedef["pos"], pos);
+    auto newid = addNode(nodedef["initialName"], nodedef["displayName"], pos + glm::vec2(100, 100));
+    Node& node = noderef(newid);
+    node.numInputs_ = nodedef["maxInputs"];
+    node.numOutputs_ = nodedef["nOutputs"];
+    from_json(nodedef["color"], node.color_);
+
+    idMap[nodedef["id"]] = newid;
+  }
+  auto transpin = [&idMap](NodePin const& pin) {
+    auto itr = idMap.find(pin.nodeIndex);
+    return NodePin{ pin.type, itr == idMap.end() ? pin.nodeIndex : itr->second, pin.pinNumber };
+  };
+  for (auto const& linkdef: uigraph["links"]) {
+    auto to = transpin(linkdef["to"]);
+    NodePin from = linkdef["from"];
+    // auto from = transpin(linkdef["from"]);
+    if (auto itr = idMap.find(from.nodeIndex); itr!=idMap.end())
+      from.nodeIndex = itr->second;
+    // resolve link by display name - for copy-pasting between totally different graphs
+    // where ids makes no sense
+    else if (linkdef.find("fromname")!=linkdef.end()) {
+      if (auto sourceitr=std::find_if(
+            nodes_.begin(), nodes_.end(),
+            [name=std::string(linkdef["fromname"])](auto const& pair) {
+              return pair.second.displayName()==name;
+            });
+          sourceitr!=nodes_.end())
+      {
+        from.nodeIndex = sourceitr->first;
+      }
+    }
+    if (nodes_.find(to.nodeIndex) != nodes_.end() && nodes_.find(from.nodeIndex) != nodes_.end())
+      addLink(from.nodeIndex, from.pinNumber, to.nodeIndex, to.pinNumber);
+  }
+  for (auto const& newitem: idMap) {
+    updateLinkPath(newitem.second);
+  }
+
+  std::set<size_t> newNodes;
+  newNodes.clear();
+  for (auto const& newitem : idMap) {
+    newNodes.insert(newitem.second);
+  }
+  if (outPastedNodes) {
+    *outPastedNodes = newNodes;
+  }
+  bool succeed = true;
+  if (hook_)
+    succeed &= hook_->onPartialLoad(this, json, newNodes, idMap);
+
+  this->notifyViewers();
+  stash();
+  return succeed;
+}
+
+std::vector<size_t> Graph::importBulk(BulkGraphData const& data, bool bypassHook)
+{
+  NG_PROFILE_SCOPE("Graph::importBulk");
+  size_t const count = data.types.size();
+  std::vector<size_t> ids(count, size_t(-1));
+  if (count == 0 && data.links.empty())
+    return ids;
+
+  std::vector<std::string> desiredNames(count);
+  for (size_t i = 0; i < count; ++i) {
+    bool const named = i < data.names.size() && !data.names[i].empty();
+    desiredNames[i]  = named ? data.names[i] : data.types[i];
+  }
+  std::vector<std::string> acceptedNames = desiredNames;
+  std::vector<void*>       payloads(count, nullptr);
+  if (hook_ && !bypassHook)
+    hook_->createNodes(this, data.types, desiredNames, acceptedNames, payloads);
+
+  nodes_.reserve(nodes_.size() + count);
+  nodeOrder_.reserve(nodeOrder_.size() + count);
+  links_.reserve(links_.size() + data.links.size());
+  linkPathes_.reserve(linkPathes_.size() + data.links.size());
+
+  for (size_t i = 0; i < count; ++i) {
+    if (hook_ && !bypassHook && !payloads[i])
+      continue;
+    size_t id = NodeIdAllocator::instance().newId();
+    Node node;
+    node.initialName_ = data.types[i];
+    node.displayName_ = std::move(acceptedNames[i]);
+    node.pos_         = i < data.positions.size() ? data.positions[i] : glm::vec2(0, 0);
+    node.color_       = i < data.colors.size() ? data.colors[i] : DEFAULT_NODE_COLOR;
+    node.hook_        = bypassHook ? nullptr : hook_; // no payload of its making
+    node.setPayload(payloads[i]);
+    nodes_.emplace(id, std::move(node));
+    nodeOrder_.push_back(id);
+    ids[i] = id;
+  }
+
+  std::vector<NodePin> newLinks;
+  newLinks.reserve(data.links.size());
+  for (auto const& link : data.links) {
+    if (link.src >= count || link.dst >= count || ids[link.src] == size_t(-1) ||
+        ids[link.dst] == size_t(-1))
+      continue;
+    Node* srcnode = &noderef(ids[link.src]);
+    Node* dstnode = &noderef(ids[link.dst]);
+    if (hook_ && !bypassHook &&
+        !hook_->linkCanBeAttached(srcnode, link.srcPin, dstnode, link.dstPin))
+      continue;
+    auto const dst = NodePin{NodePin::INPUT, ids[link.dst], link.dstPin};
+    auto const src = NodePin{NodePin::OUTPUT, ids[link.src], link.srcPin};
+    auto [itr, inserted] = links_.insert({dst, src});
+    if (!inserted) { // same input pin was linked twice, the later one wins
+      if (hook_)
+        hook_->onLinkDetached(
+            &noderef(itr->second.nodeIndex), itr->second.pinNumber, dstnode, dst.pinNumber);
+      itr->second = src;
+    } else {
+      newLinks.push_back(dst);
+    }
+    if (hook_) // as addLink does, bypassHook only skips the veto
+      hook_->onLinkAttached(srcnode, link.srcPin, dstnode, link.dstPin);
+  }
+
+  syncRouting(false); // the new nodes are obstacles to the new links
+  for (auto const& dst : newLinks)
+    buildLinkPath(dst, links_.at(dst));
+
+  notifyViewers();
+  stash();
+  return ids;
+}
+
+bool Graph::save(nlohmann::json& section, std::string const& path) const
+{
+  NG_PROFILE_SCOPE("Graph::save");
+  auto& uigraph = section["uigraph"];
+  auto& nodesection = uigraph["nodes"];
+  for (auto const& n : nodes_) {
+    nlohmann::json nodedef;
+    nodedef["id"] = n.first;
+    nodedef["initialName"] = n.second.initialName();
+    nodedef["displayName"] = n.second.displayName();
+    nodedef["minInputs"] = n.second.minInputCount();
+    nodedef["maxInputs"] = n.second.maxInputCount();
+    nodedef["nOutputs"] = n.second.outputCount();
+    to_json(nodedef["color"], n.second.color());
+    to_json(nodedef["pos"],   n.second.pos());
+
+    nodesection.push_back(nodedef);
+  }
+  auto& linksection = uigraph["links"];
+  for (auto const& link: links_) {
+    nlohmann::json linkdef;
+    linkdef["from"] = { {"node", link.second.nodeIndex}, {"pin", link.second.pinNumber} };
+    linkdef["to"] = { {"node", link.first.nodeIndex}, {"pin", link.first.pinNumber} };
+
+    linksection.push_back(linkdef);
+  }
+  uigraph["order"] = nodeOrder_;
+
+  if (hook_) {
+    hook_->onSave(this, section, path);
+  }
+  if (!path.empty())
+    savePath_ = path;
+
+  return true;
+}
+
+bool Graph::load(nlohmann::json const& section, std::string const& path)
+{
+  NG_PROFILE_SCOPE("Graph::load");
+  if (hook_) {
+    for (auto& n : nodes_) {
+      hook_->beforeDeleteNode(&n.second);
+    }
+  }
+  nodes_.clear();
+  links_.clear();
+  nodeOrder_.clear(); // link paths are kept as placeholders, see updateAllLinkPaths()
+
+  auto const& uigraph = section["uigraph"];
+  size_t maxNodeId = 0;
+  for (auto const& n: uigraph["nodes"]) {
+    Node node;
+    node.initialName_ = n["initialName"];
+    node.displayName_ = n["displayName"];
+    node.numInputs_ = n["maxInputs"];
+    node.numOutputs_ = n["nOutputs"];
+    node.hook_ = nullptr; // Hooks are processed later
+    from_json(n["color"], node.color_);
+    from_json(n["pos"], node.pos_);
+
+    size_t id = n["id"];
+    nodes_[id] = node;
+
+    maxNodeId = std::max(id, maxNodeId);
+  }
+  NodeIdAllocator::instance().setInitialId(maxNodeId+1);
+  for (auto const& link: uigraph["links"]) {
+    size_t const from = link["from"]["node"], to = link["to"]["node"];
+    // dangling links, e.g. of hand edited files, are dropped rather than given nodes
+    if (nodes_.find(from) == nodes_.end() || nodes_.find(to) == nodes_.end())
+      continue;
+    links_[NodePin{NodePin::INPUT, to, link["to"]["pin"]}] =
+        NodePin{NodePin::OUTPUT, from, link["from"]["pin"]};
+  }
+  if (uigraph.find("order")!=uigraph.end()) {
+    for (size_t id : uigraph["order"]) {
+      nodeOrder_.push_back(id);
+    }
+  } else {
+    for (auto const& n : nodes_)
+      nodeOrder_.push_back(n.first);
+  }
+
+  updateAllLinkPaths();
+
+  bool succeed = true;
+  if(hook_) {
+    succeed &= hook_->onLoad(this, section, path);
+  }
+  this->notifyViewers();
+  if (!path.empty()) {
+    undoStack_.reset(nullptr);
+    stash();
+    savePath_ = path;
+    for (auto *v: viewers_) {
+      v->needsFocus = true;
+    }
+  }
+  return succeed;
+}
+
+bool Graph::stash()
+{
+  NG_PROFILE_SCOPE("Graph::stash");
+  ++version_; // edits are stashed, including those made through nodes directly
+  if (!undoStack_)
+    undoStack_.reset(new UndoStackImpl());
+  return undoStack_->stash(*this);
+}
+
+void Graph::resetHistory()
+{
+  undoStack_.reset(nullptr);
+  stash();
+}
+
+bool Graph::undo()
+{
+  NG_PROFILE_SCOPE("Graph::undo");
+  if (!undoStack_)
+    return false;
+  return undoStack_->undo(*this);
+}
+
+bool Graph::redo()
+{
+  NG_PROFILE_SCOPE("Graph::redo");
+  if (!undoStack_)
+    return false;
+  return undoStack_->redo(*this);
+}
+
+} // namespace editorui
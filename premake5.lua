@@ -23,6 +23,11 @@ newoption({
   description='using opengl3 implement'
 })
 
+newoption({
+  trigger='headless',
+  description='no window / gpu, null renderer & synthetic input for benchmarking'
+})
+
 local projectndf = function(root_dir)
   project "nfd"
     kind "StaticLib"
@@ -122,6 +127,13 @@ project('imgui')
     else
       linklater({'glfw','GL','dl','pthread'})
     end
+  elseif _OPTIONS['headless'] then
+    files{'entry/headless_main.cpp'}
+    if os.target()=='windows' then
+      linklater({'ole32','uuid'})
+    else
+      linklater({'dl','pthread'})
+    end
   else
     files({'deps/imgui/backends/imgui_impl_win32.*', 'deps/imgui/backends/imgui_impl_dx11.*'})
     files{'entry/dx11_main.cpp'}
@@ -162,3 +174,66 @@ project('nodegrapher')
   
   
 
+
+-- headless command line tool, graph model only
+project('graphtool')
+  kind('ConsoleApp')
+  includedirs({
+    'deps/glm',
+    'deps/json',
+  })
+  files({
+    'nodegraph.h', 'nodegraph_model.cpp', 'linkrouter.*', 'layout.*', 'profiler.*',
+    'tracer.*', 'instrumentedhook.*', 'tools/graphtool.cpp'
+  })
+  filter('system:not windows')
+    links({'pthread'}) -- link path worker
+  filter({'action:vs*'})
+    buildoptions({'/std:c++17'})
+  filter({'toolset:clang or gcc'})
+    buildoptions({'-std=c++17'})
+
+-- micro benchmarks of the graph model on synthetic graphs
+project('graphbench')
+  kind('ConsoleApp')
+  includedirs({
+    'deps/glm',
+    'deps/json',
+  })
+  files({
+    'nodegraph.h', 'nodegraph_model.cpp', 'linkrouter.*', 'layout.*', 'profiler.*',
+    'tracer.*', 'instrumentedhook.*', 'tools/graphgen.*', 'tools/graphbench.cpp'
+  })
+  filter('system:not windows')
+    links({'pthread'}) -- link path worker
+  filter({'action:vs*'})
+    buildoptions({'/std:c++17'})
+  filter({'toolset:clang or gcc'})
+    buildoptions({'-std=c++17'})
+
+-- rendering scenarios for updateNetworkView / drawGraph on a headless ImGui context
+project('renderbench')
+  kind('ConsoleApp')
+  includedirs({
+    'deps/imgui',
+    'deps/spdlog/include',
+    'deps/glm',
+    'deps/json',
+    'deps/nativefiledialog/src/include',
+  })
+  files({
+    'nodegraph.h', 'nodegraph.cpp', 'nodegraph_model.cpp', 'linkrouter.*', 'layout.*',
+    'profiler.*', 'tracer.*', 'instrumentedhook.*', 'inputsession.*', 'latency.*', 'governor.*',
+    'transform2d.*',
+    'roboto_medium.cpp', 'sourcecodepro.cpp', 'fa_*',
+    'tools/graphgen.*', 'tools/renderbench.cpp'
+  })
+  links({'imgui', 'spdlog', 'nfd'})
+  filter('system:windows')
+    links({ "ole32", "uuid", "ws2_32", "advapi32", "version"})
+  filter('system:not windows')
+    links({'dl', 'pthread'})
+  filter({'action:vs*'})
+    buildoptions({'/std:c++17'})
+  filter({'toolset:clang or gcc'})
+    buildoptions({'-std=c++17'})
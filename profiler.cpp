@@ -0,0 +1,259 @@
+#include "profiler.h"
+#include "tracer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+namespace editorui {
+namespace profiler {
+
+namespace {
+
+struct Phase
+{
+  char const* name        = nullptr;
+  double      inclusiveMs = 0;
+  double      exclusiveMs = 0;
+  int64_t     calls       = 0;
+  int64_t     counter     = 0;
+
+  // current frame, moved into history at endFrame()
+  double                            frameMs      = 0;
+  int64_t                           frameCalls   = 0;
+  int64_t                           frameCounter = 0;
+  int64_t                           lastCalls    = 0;
+  int64_t                           lastCount    = 0;
+  std::array<float, HISTORY_FRAMES> history      = {};
+};
+
+struct State
+{
+  std::atomic<bool>             enabled = {false};
+  std::mutex                    registryMutex;
+  std::array<Phase, MAX_PHASES> phases;
+  std::atomic<int>              phaseCount  = {0};
+  int64_t                       frames      = 0;
+  double                        frameStart  = 0;
+  int                           historyHead = 0; // next slot to write
+  int                           historySize = 0;
+};
+
+State& state()
+{
+  static State s;
+  return s;
+}
+
+struct OpenScope
+{
+  int    phase;
+  double childMs; // time spent in nested scopes
+};
+
+// only the thread driving frames records, scopes on other threads are no-ops
+thread_local bool                   tlsRecording = false;
+thread_local std::vector<OpenScope> tlsOpenScopes;
+
+} // namespace
+
+bool enabled()
+{
+  return state().enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled)
+{
+  state().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+int phaseId(char const* name)
+{
+  auto&                       s = state();
+  std::lock_guard<std::mutex> lock(s.registryMutex);
+  int const                   count = s.phaseCount.load();
+  for (int i = 0; i < count; ++i)
+    if (strcmp(s.phases[i].name, name) == 0)
+      return i;
+  if (count >= MAX_PHASES)
+    return -1;
+  s.phases[count].name = name;
+  s.phaseCount.store(count + 1);
+  return count;
+}
+
+void beginFrame()
+{
+  trace::begin("frame");
+  tlsRecording = true;
+  tlsOpenScopes.clear();
+  state().frameStart = now();
+}
+
+void endFrame()
+{
+  static int const framePhase = phaseId("frame");
+  trace::end("frame");
+  if (!enabled())
+    return;
+  auto& s = state();
+  if (framePhase >= 0) {
+    double const duration = now() - s.frameStart;
+    auto&        p        = s.phases[framePhase];
+    p.inclusiveMs += duration;
+    p.exclusiveMs += duration;
+    p.frameMs += duration;
+    ++p.calls;
+    ++p.frameCalls;
+  }
+  for (int i = 0, n = s.phaseCount.load(); i < n; ++i) {
+    auto& p                  = s.phases[i];
+    p.history[s.historyHead] = float(p.frameMs);
+    p.lastCalls              = p.frameCalls;
+    p.lastCount              = p.frameCounter;
+    p.frameMs                = 0;
+    p.frameCalls             = 0;
+    p.frameCounter           = 0;
+  }
+  s.historyHead = (s.historyHead + 1) % HISTORY_FRAMES;
+  s.historySize = std::min(s.historySize + 1, HISTORY_FRAMES);
+  ++s.frames;
+}
+
+Scope::Scope(int phase)
+    : phase_(-1)
+    , start_(0)
+    , traced_(nullptr)
+{
+  if (phase < 0)
+    return;
+  if (trace::recording()) {
+    traced_ = state().phases[phase].name;
+    trace::begin(traced_);
+  }
+  if (!tlsRecording || !enabled())
+    return;
+  phase_ = phase;
+  start_ = now();
+  tlsOpenScopes.push_back({phase, 0});
+}
+
+Scope::~Scope()
+{
+  end();
+}
+
+void Scope::end()
+{
+  if (traced_) {
+    trace::end(traced_);
+    traced_ = nullptr;
+  }
+  if (phase_ < 0)
+    return;
+  double const duration = now() - start_;
+  double const children = tlsOpenScopes.back().childMs;
+  tlsOpenScopes.pop_back();
+  if (!tlsOpenScopes.empty())
+    tlsOpenScopes.back().childMs += duration;
+  auto& p = state().phases[phase_];
+  p.inclusiveMs += duration;
+  p.exclusiveMs += duration - children;
+  p.frameMs += duration;
+  ++p.calls;
+  ++p.frameCalls;
+  phase_ = -1;
+}
+
+int currentPhase()
+{
+  return tlsOpenScopes.empty() ? -1 : tlsOpenScopes.back().phase;
+}
+
+char const* phaseName(int phase)
+{
+  auto& s = state();
+  return phase >= 0 && phase < s.phaseCount.load() ? s.phases[phase].name : nullptr;
+}
+
+void count(int phase, int64_t value)
+{
+  if (phase < 0 || !tlsRecording || !enabled())
+    return;
+  auto& p = state().phases[phase];
+  p.counter += value;
+  p.frameCounter += value;
+}
+
+std::vector<PhaseTotal> totals()
+{
+  auto&                   s = state();
+  std::vector<PhaseTotal> result;
+  for (int i = 0, n = s.phaseCount.load(); i < n; ++i) {
+    auto const& p = s.phases[i];
+    result.push_back({p.name, p.inclusiveMs, p.exclusiveMs, p.calls, p.counter});
+  }
+  return result;
+}
+
+std::vector<PhaseStats> stats()
+{
+  auto&                   s = state();
+  std::vector<PhaseStats> result;
+  std::vector<float>      sorted;
+  for (int i = 0, n = s.phaseCount.load(); i < n; ++i) {
+    auto const& p = s.phases[i];
+    PhaseStats  st;
+    st.name      = p.name;
+    st.lastCalls = p.lastCalls;
+    st.lastCount = p.lastCount;
+    st.history.resize(s.historySize);
+    for (int k = 0; k < s.historySize; ++k)
+      st.history[k] =
+          p.history[(s.historyHead - s.historySize + k + HISTORY_FRAMES) % HISTORY_FRAMES];
+    if (!st.history.empty()) {
+      sorted = st.history;
+      std::sort(sorted.begin(), sorted.end());
+      double sum = 0;
+      for (float ms : sorted)
+        sum += ms;
+      st.lastMs = st.history.back();
+      st.minMs  = sorted.front();
+      st.meanMs = float(sum / sorted.size());
+      st.p99Ms  = sorted[std::min(sorted.size() - 1, size_t(0.99 * (sorted.size() - 1) + 0.5))];
+    }
+    result.push_back(std::move(st));
+  }
+  return result;
+}
+
+int64_t frameCount()
+{
+  return state().frames;
+}
+
+void reset()
+{
+  auto& s = state();
+  for (int i = 0, n = s.phaseCount.load(); i < n; ++i) {
+    auto& p       = s.phases[i];
+    p.inclusiveMs = p.exclusiveMs = 0;
+    p.calls = p.counter = 0;
+    p.history.fill(0);
+  }
+  s.frames      = 0;
+  s.historyHead = 0;
+  s.historySize = 0;
+}
+
+double now()
+{
+  using namespace std::chrono;
+  return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace profiler
+} // namespace editorui
@@ -0,0 +1,104 @@
+#pragma once
+// lightweight scoped timers & counters for the editor
+// no ImGui in here - the model and headless tools use it too
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace editorui {
+namespace profiler {
+
+bool enabled();
+void setEnabled(bool enabled);
+
+/// phase ids are below this
+constexpr int MAX_PHASES = 256;
+
+/// registers a phase name (use a string literal, the pointer is kept) and returns its id,
+/// -1 once MAX_PHASES are registered
+/// slash separated names are shown as a tree, e.g. "drawGraph/links"
+int phaseId(char const* name);
+
+/// per-frame bookkeeping, call around each frame of the main thread
+/// the time in between is recorded as phase "frame", and traced as such
+void beginFrame();
+void endFrame();
+
+/// times the enclosing block into given phase
+/// nested scopes are subtracted from the parent's exclusive time
+/// while a trace is recording (see tracer.h), also emits begin / end events, on any thread
+class Scope
+{
+  int         phase_;
+  double      start_;
+  char const* traced_; // phase name if a begin event was emitted
+
+public:
+  explicit Scope(int phase);
+  ~Scope();
+  void end(); // stops timing before the end of the block, scopes must still end in order
+  Scope(Scope const&) = delete;
+  Scope& operator=(Scope const&) = delete;
+};
+
+/// innermost open scope of the calling thread, -1 if none or not recording
+int currentPhase();
+
+/// name given to phaseId(), nullptr for invalid ids
+char const* phaseName(int phase);
+
+/// adds value to the counter of given phase in current frame (e.g. emitted vertices)
+void count(int phase, int64_t value);
+
+struct PhaseTotal
+{
+  char const* name        = "";
+  double      inclusiveMs = 0;
+  double      exclusiveMs = 0;
+  int64_t     calls       = 0;
+  int64_t     counter     = 0;
+};
+
+/// totals accumulated over all frames since last reset()
+std::vector<PhaseTotal> totals();
+int64_t                 frameCount();
+void                    reset();
+
+/// number of frames kept in the rolling history
+constexpr int HISTORY_FRAMES = 240;
+
+/// rolling per-frame history of a phase over the last HISTORY_FRAMES frames
+struct PhaseStats
+{
+  char const*        name = "";
+  std::vector<float> history; // inclusive ms of each frame, oldest first
+  float              lastMs    = 0;
+  float              minMs     = 0;
+  float              meanMs    = 0;
+  float              p99Ms     = 0;
+  int64_t            lastCalls = 0; // scopes closed in the last frame
+  int64_t            lastCount = 0; // counter of the last frame
+};
+std::vector<PhaseStats> stats();
+
+/// monotonic clock in milliseconds
+double now();
+
+} // namespace profiler
+} // namespace editorui
+
+#define NG_PROFILE_CONCAT_(a, b) a##b
+#define NG_PROFILE_CONCAT(a, b)  NG_PROFILE_CONCAT_(a, b)
+#define NG_PROFILE_SCOPE(name)                                                               \
+  static int const NG_PROFILE_CONCAT(ngProfilePhase, __LINE__) =                             \
+      ::editorui::profiler::phaseId(name);                                                   \
+  ::editorui::profiler::Scope NG_PROFILE_CONCAT(ngProfileScope,                              \
+                                                __LINE__)(NG_PROFILE_CONCAT(ngProfilePhase, \
+                                                                            __LINE__))
+
+#define NG_PROFILE_COUNT(name, value)                                                        \
+  do {                                                                                       \
+    static int const ngProfileCounter = ::editorui::profiler::phaseId(name);                 \
+    ::editorui::profiler::count(ngProfileCounter, value);                                    \
+  } while (0)
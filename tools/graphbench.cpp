@@ -0,0 +1,417 @@
+// graphbench - micro benchmarks of the Graph model on synthetic graphs
+// results are written as JSON, so that runs of different versions can be compared
+
+#include "../layout.h"
+#include "../nodegraph.h"
+#include "graphgen.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using editorui::BulkGraphData;
+using editorui::Graph;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Config
+{
+  std::vector<size_t>      sizes      = {1000, 10000};
+  std::vector<std::string> generators = graphgen::generatorNames();
+  std::set<std::string>    ops; // empty: all
+  size_t                   batch    = 64;   // selection size for batch ops
+  double                   budgetMs = 1000; // time budget per op
+  size_t                   maxIters = 1000; // iteration cap per op
+};
+
+struct Result
+{
+  std::string generator;
+  size_t      nodes      = 0;
+  size_t      links      = 0;
+  std::string op;
+  size_t      iterations = 0;
+  double      totalMs    = 0;
+  double      minUs      = 0;
+  double      maxUs      = 0;
+};
+
+// runs `body` until either maxIters or the time budget is reached, at least once
+// `prepare` runs before each iteration and is not timed
+Result measure(Config const&               cfg,
+               std::function<void()> const& prepare,
+               std::function<void()> const& body)
+{
+  Result r;
+  r.minUs = 1e300;
+  auto const start = Clock::now();
+  while (r.iterations < cfg.maxIters) {
+    if (prepare)
+      prepare();
+    auto const t0 = Clock::now();
+    body();
+    double const us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+    r.totalMs += us / 1000.0;
+    r.minUs = std::min(r.minUs, us);
+    r.maxUs = std::max(r.maxUs, us);
+    ++r.iterations;
+    if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() > cfg.budgetMs)
+      break;
+  }
+  return r;
+}
+
+std::vector<size_t> sampleNodes(Graph const& g, size_t count, std::mt19937& rng)
+{
+  std::vector<size_t> ids = g.order();
+  std::shuffle(ids.begin(), ids.end(), rng);
+  ids.resize(std::min(count, ids.size()));
+  return ids;
+}
+
+std::unique_ptr<Graph> build(BulkGraphData const& data)
+{
+  auto graph = std::make_unique<Graph>();
+  graph->importBulk(data);
+  return graph;
+}
+
+void run(Config const& cfg, std::string const& gen, size_t n, std::vector<Result>& results)
+{
+  BulkGraphData data;
+  graphgen::generate(gen, n, data);
+  auto const wanted = [&cfg](char const* op) { return cfg.ops.empty() || cfg.ops.count(op); };
+  auto const record = [&](char const* op, Result r) {
+    r.generator = gen;
+    r.nodes     = data.types.size();
+    r.links     = data.links.size();
+    r.op        = op;
+    fprintf(stderr,
+            "%-8s %8zu %-14s %6zu iters  mean %12.3f us\n",
+            gen.c_str(),
+            r.nodes,
+            op,
+            r.iterations,
+            r.totalMs * 1000.0 / r.iterations);
+    results.push_back(std::move(r));
+  };
+
+  std::mt19937           rng(1234);
+  std::unique_ptr<Graph> graph;
+  auto const             fresh = [&] { graph = build(data); };
+
+  if (wanted("importBulk")) {
+    std::unique_ptr<Graph> target;
+    record("importBulk",
+           measure(
+               cfg,
+               [&] { target = std::make_unique<Graph>(); },
+               [&] { target->importBulk(data); }));
+  }
+  if (wanted("addNode")) {
+    fresh();
+    glm::vec2 pos = {0, -100};
+    record("addNode",
+           measure(cfg, nullptr, [&] {
+             graph->addNode("node", "node", pos);
+             pos.x += 100;
+           }));
+  }
+  if (wanted("addLink")) {
+    fresh();
+    auto const& order = graph->order();
+    if (!order.empty()) { // picks among the nodes
+      std::uniform_int_distribution<size_t> pick(0, order.size() - 1);
+      record("addLink", measure(cfg, nullptr, [&] {
+               graph->addLink(order[pick(rng)], 0, order[pick(rng)], 3);
+             }));
+    }
+  }
+  if (wanted("removeNodes")) {
+    fresh();
+    std::vector<size_t> victims;
+    record("removeNodes",
+           measure(
+               cfg,
+               [&] {
+                 if (graph->nodes().size() < cfg.batch * 2)
+                   fresh();
+                 victims = sampleNodes(*graph, cfg.batch, rng);
+               },
+               [&] { graph->removeNodes(victims); }));
+  }
+  if (wanted("moveNodes")) {
+    fresh();
+    auto const selection = sampleNodes(*graph, cfg.batch, rng);
+    record("moveNodes",
+           measure(cfg, nullptr, [&] { graph->moveNodes(selection, glm::vec2(1, 1)); }));
+  }
+  if (wanted("updateLinkPath")) {
+    fresh();
+    auto const& order = graph->order();
+    if (!order.empty()) { // picks among the nodes
+      std::uniform_int_distribution<size_t> pick(0, order.size() - 1);
+      record("updateLinkPath",
+             measure(cfg, nullptr, [&] { graph->updateLinkPath(order[pick(rng)]); }));
+    }
+  }
+  if (wanted("genLinkPath")) {
+    fresh();
+    record("genLinkPath", measure(cfg, nullptr, [&] {
+             for (auto const& link : graph->links()) {
+               auto const& src = graph->noderef(link.second.nodeIndex);
+               auto const& dst = graph->noderef(link.first.nodeIndex);
+               Graph::genLinkPath(src.outputPinPos(link.second.pinNumber),
+                                  dst.inputPinPos(link.first.pinNumber),
+                                  std::min(src.size().x, dst.size().x));
+             }
+           }));
+  }
+  if (wanted("routeAll")) {
+    fresh();
+    graph->setLinkRouting(true);
+    record("routeAll", measure(cfg, nullptr, [&] { graph->updateAllLinkPaths(); }));
+  }
+  if (wanted("routedMove")) {
+    // dragging one node with links routed around nodes: only links passing by are rerouted
+    fresh();
+    graph->setLinkRouting(true);
+    std::vector<size_t> const dragged = sampleNodes(*graph, 1, rng);
+    glm::vec2                 delta   = {3, 1};
+    record("routedMove", measure(cfg, nullptr, [&] {
+             graph->moveNodes(dragged, delta);
+             delta = -delta;
+           }));
+  }
+  if (wanted("layout")) {
+    fresh();
+    record("layout", measure(cfg, nullptr, [&] { editorui::layout::layered(*graph); }));
+  }
+  if (wanted("layoutSelection")) {
+    fresh();
+    std::set<size_t> selection;
+    for (size_t id : sampleNodes(*graph, cfg.batch, rng))
+      selection.insert(id);
+    record("layoutSelection",
+           measure(cfg, nullptr, [&] { editorui::layout::layered(*graph, &selection); }));
+  }
+  if (wanted("forceLayout")) {
+    fresh();
+    record("forceLayout", measure(cfg, nullptr, [&] { editorui::layout::force(*graph); }));
+  }
+  if (wanted("forceStep")) { // one frame of an animated force layout
+    fresh();
+    auto layout = std::make_unique<editorui::layout::ForceLayout>(*graph);
+    record("forceStep", measure(cfg, nullptr, [&] {
+             if (!layout->step(*graph, 0)) // one tick
+               layout = std::make_unique<editorui::layout::ForceLayout>(*graph);
+           }));
+  }
+  nlohmann::json saved;
+  if (wanted("save") || wanted("load")) {
+    fresh();
+    record("save",
+           measure(
+               cfg, [&] { saved = nlohmann::json(); }, [&] { graph->save(saved, ""); }));
+  }
+  if (wanted("load")) {
+    Graph target;
+    record("load", measure(cfg, nullptr, [&] { target.load(saved, ""); }));
+  }
+  nlohmann::json partial;
+  if (wanted("partialSave") || wanted("partialLoad")) {
+    fresh();
+    std::set<size_t> selection;
+    for (size_t id : sampleNodes(*graph, cfg.batch, rng))
+      selection.insert(id);
+    record("partialSave",
+           measure(
+               cfg,
+               [&] { partial = nlohmann::json(); },
+               [&] { graph->partialSave(partial, selection); }));
+  }
+  if (wanted("partialLoad")) {
+    record("partialLoad", measure(cfg, nullptr, [&] { graph->partialLoad(partial); }));
+  }
+  if (wanted("undo") || wanted("redo")) {
+    fresh();
+    graph->moveNodes(sampleNodes(*graph, cfg.batch, rng), glm::vec2(10, 10));
+    graph->stash();
+    // alternate undo / redo so that there is always something to undo or redo
+    record("undo", measure(cfg, [&] { graph->redo(); }, [&] { graph->undo(); }));
+    record("redo", measure(cfg, [&] { graph->undo(); }, [&] { graph->redo(); }));
+  }
+}
+
+template<class T, class Parse>
+std::vector<T> splitList(std::string const& str, Parse parse)
+{
+  std::vector<T>    result;
+  std::stringstream ss(str);
+  std::string       item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      result.push_back(parse(item));
+  return result;
+}
+
+// the whole of text as a count, with an optional k or M suffix (1k = 1000), false if it is
+// not one or out of range
+bool parseCount(std::string const& text, size_t& value)
+{
+  if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+    return false; // strtoull would take leading blanks & signs
+  char* end = nullptr;
+  errno     = 0;
+  unsigned long long const v     = std::strtoull(text.c_str(), &end, 10);
+  unsigned long long       scale = 1;
+  if (*end == 'k')
+    scale = 1000, ++end;
+  else if (*end == 'M')
+    scale = 1000000, ++end;
+  if (*end != '\0' || errno == ERANGE || v > SIZE_MAX / scale)
+    return false;
+  value = size_t(v * scale);
+  return true;
+}
+
+// the whole of text as a finite number, false if it is not one
+bool parseNumber(std::string const& text, double& value)
+{
+  char* end = nullptr;
+  errno     = 0;
+  double const v = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || errno == ERANGE || !std::isfinite(v))
+    return false;
+  value = v;
+  return true;
+}
+
+void usage()
+{
+  printf("usage: graphbench [options]\n"
+         "  --sizes 1k,10k                node counts, at least 1, with an optional k or M\n"
+         "                                suffix, generators scale up to 1M\n"
+         "  --generators chain,tree,...   chain tree fanout dag grid\n"
+         "  --ops addNode,save,...        importBulk addNode addLink removeNodes moveNodes\n"
+         "                                updateLinkPath genLinkPath routeAll routedMove\n"
+         "                                layout layoutSelection forceLayout forceStep\n"
+         "                                save load partialSave partialLoad undo redo\n"
+         "  --batch N                     selection size of batch ops (64)\n"
+         "  --budget MS                   time budget per op (1000)\n"
+         "  --iterations N                iteration cap per op (1000)\n"
+         "  --out file.json               write results there instead of stdout\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Config      cfg;
+  std::string outPath;
+  auto const  bad = [](std::string const& option, std::string const& value) {
+    fprintf(stderr, "%s expects a number, got \"%s\"\n", option.c_str(), value.c_str());
+    usage();
+    return 1;
+  };
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg  = argv[i];
+    bool const        more = i + 1 < argc;
+    auto const        str  = [](std::string const& s) { return s; };
+    if (arg == "--sizes" && more) {
+      cfg.sizes.clear();
+      for (auto const& item : splitList<std::string>(argv[++i], str)) {
+        size_t n = 0;
+        if (!parseCount(item, n) || n < 1)
+          return bad(arg, item);
+        cfg.sizes.push_back(n);
+      }
+    } else if (arg == "--generators" && more)
+      cfg.generators = splitList<std::string>(argv[++i], str);
+    else if (arg == "--ops" && more)
+      for (auto const& op : splitList<std::string>(argv[++i], str))
+        cfg.ops.insert(op);
+    else if (arg == "--batch" && more) {
+      if (!parseCount(argv[++i], cfg.batch))
+        return bad(arg, argv[i]);
+      cfg.batch = std::max<size_t>(1, cfg.batch);
+    } else if (arg == "--budget" && more) {
+      if (!parseNumber(argv[++i], cfg.budgetMs))
+        return bad(arg, argv[i]);
+    } else if (arg == "--iterations" && more) {
+      if (!parseCount(argv[++i], cfg.maxIters))
+        return bad(arg, argv[i]);
+      cfg.maxIters = std::max<size_t>(1, cfg.maxIters);
+    } else if (arg == "--out" && more)
+      outPath = argv[++i];
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  std::vector<Result> results;
+  for (auto const& gen : cfg.generators) {
+    BulkGraphData probe;
+    if (!graphgen::generate(gen, 0, probe)) {
+      fprintf(stderr, "unknown generator \"%s\"\n", gen.c_str());
+      return 1;
+    }
+    for (size_t n : cfg.sizes)
+      run(cfg, gen, n, results);
+  }
+
+  char      timestamp[32] = {0};
+  auto const now          = std::time(nullptr);
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  nlohmann::json report = {
+      {"benchmark", "graphbench"},
+      {"timestamp", timestamp},
+      {"config",
+       {{"batch", cfg.batch}, {"budgetMs", cfg.budgetMs}, {"maxIterations", cfg.maxIters}}},
+      {"results", nlohmann::json::array()},
+  };
+  for (auto const& r : results) {
+    report["results"].push_back({
+        {"generator", r.generator},
+        {"nodes", r.nodes},
+        {"links", r.links},
+        {"op", r.op},
+        {"iterations", r.iterations},
+        {"totalMs", r.totalMs},
+        {"meanUs", r.totalMs * 1000.0 / r.iterations},
+        {"minUs", r.minUs},
+        {"maxUs", r.maxUs},
+    });
+  }
+
+  if (outPath.empty()) {
+    printf("%s\n", report.dump(2).c_str());
+  } else {
+    std::ofstream ofile(outPath, std::ios::binary);
+    if (!ofile) {
+      fprintf(stderr, "cannot open \"%s\" for writing\n", outPath.c_str());
+      return 1;
+    }
+    ofile << report.dump(2) << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "graphgen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace graphgen {
+
+static constexpr float X_SPACING = 96.f;
+static constexpr float Y_SPACING = 80.f;
+
+static void reserve(BulkGraphData& data, size_t n, size_t links)
+{
+  data.types.assign(n, "node");
+  data.names.resize(n);
+  data.positions.resize(n);
+  data.links.reserve(links);
+  for (size_t i = 0; i < n; ++i)
+    data.names[i] = "node_" + std::to_string(i);
+}
+
+BulkGraphData chain(size_t n)
+{
+  BulkGraphData data;
+  reserve(data, n, n ? n - 1 : 0);
+  for (size_t i = 0; i < n; ++i) {
+    data.positions[i] = {0.f, i * Y_SPACING};
+    if (i > 0)
+      data.links.push_back({i - 1, 0, i, 0});
+  }
+  return data;
+}
+
+BulkGraphData tree(size_t n, int fanout)
+{
+  BulkGraphData data;
+  fanout = std::max(1, fanout);
+  reserve(data, n, n ? n - 1 : 0);
+  // breadth first numbering: children of i are i*fanout+1 .. i*fanout+fanout
+  size_t levelStart = 0, levelSize = 1, depth = 0;
+  while (levelStart < n) {
+    for (size_t k = 0; k < levelSize && levelStart + k < n; ++k) {
+      size_t const i    = levelStart + k;
+      data.positions[i] = {(k - levelSize * 0.5f) * X_SPACING, depth * Y_SPACING};
+      if (i > 0)
+        data.links.push_back({(i - 1) / fanout, 0, i, 0});
+    }
+    levelStart += levelSize;
+    levelSize *= fanout;
+    ++depth;
+  }
+  return data;
+}
+
+BulkGraphData fanOut(size_t n)
+{
+  BulkGraphData data;
+  reserve(data, n, n ? n - 1 : 0);
+  if (n == 0)
+    return data;
+  size_t const columns = std::max<size_t>(1, size_t(std::sqrt(double(n))));
+  data.positions[0]    = {columns * X_SPACING * 0.5f, 0.f};
+  for (size_t i = 1; i < n; ++i) {
+    size_t const row  = (i - 1) / columns;
+    size_t const col  = (i - 1) % columns;
+    data.positions[i] = {col * X_SPACING, (row + 2) * Y_SPACING};
+    data.links.push_back({0, 0, i, 0});
+  }
+  return data;
+}
+
+BulkGraphData randomDag(size_t n, int maxInputs, uint32_t seed)
+{
+  BulkGraphData data;
+  maxInputs = std::max(1, std::min(maxInputs, 4));
+  reserve(data, n, n * maxInputs);
+  std::mt19937                       rng(seed);
+  std::uniform_int_distribution<int> inputCount(1, maxInputs);
+  size_t const columns = std::max<size_t>(1, size_t(std::sqrt(double(n))));
+  for (size_t i = 0; i < n; ++i) {
+    data.positions[i] = {(i % columns) * X_SPACING * 1.5f, (i / columns) * Y_SPACING * 1.5f};
+    if (i == 0)
+      continue;
+    // prefer nearby sources so that links stay local, like real pipelines
+    size_t const window = std::min<size_t>(i, columns * 2);
+    std::uniform_int_distribution<size_t> source(i - window, i - 1);
+    int const inputs = inputCount(rng);
+    for (int pin = 0; pin < inputs; ++pin)
+      data.links.push_back({source(rng), 0, i, pin});
+  }
+  return data;
+}
+
+BulkGraphData grid(size_t n)
+{
+  BulkGraphData data;
+  size_t const side = std::max<size_t>(1, size_t(std::ceil(std::sqrt(double(n)))));
+  reserve(data, n, n * 2);
+  for (size_t i = 0; i < n; ++i) {
+    size_t const row  = i / side;
+    size_t const col  = i % side;
+    data.positions[i] = {col * X_SPACING, row * Y_SPACING};
+    if (row > 0)
+      data.links.push_back({i - side, 0, i, 0});
+    if (col > 0)
+      data.links.push_back({i - 1, 0, i, 1});
+  }
+  return data;
+}
+
+bool generate(std::string const& name, size_t n, BulkGraphData& out)
+{
+  if (name == "chain")
+    out = chain(n);
+  else if (name == "tree")
+    out = tree(n);
+  else if (name == "fanout")
+    out = fanOut(n);
+  else if (name == "dag")
+    out = randomDag(n);
+  else if (name == "grid")
+    out = grid(n);
+  else
+    return false;
+  return true;
+}
+
+std::vector<std::string> const& generatorNames()
+{
+  static std::vector<std::string> const names = {"chain", "tree", "fanout", "dag", "grid"};
+  return names;
+}
+
+} // namespace graphgen
@@ -0,0 +1,37 @@
+#pragma once
+// synthetic graph generators for benchmarks
+// all generators produce columnar data for Graph::importBulk,
+// positions follow the top-down pin layout (inputs above, outputs below)
+
+#include "../nodegraph.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graphgen {
+
+using editorui::BulkGraphData;
+
+// 0 -> 1 -> 2 -> ... -> n-1
+BulkGraphData chain(size_t n);
+
+// complete out-tree, each node feeds `fanout` children
+BulkGraphData tree(size_t n, int fanout = 2);
+
+// one source feeding n-1 sinks
+BulkGraphData fanOut(size_t n);
+
+// each node takes up to `maxInputs` sources from earlier nodes, always a DAG
+BulkGraphData randomDag(size_t n, int maxInputs = 3, uint32_t seed = 42);
+
+// sqrt(n) x sqrt(n) grid, each node takes input from its upper and left neighbours
+BulkGraphData grid(size_t n);
+
+// generator by name: chain, tree, fanout, dag, grid
+// returns false if the name is unknown
+bool generate(std::string const& name, size_t n, BulkGraphData& out);
+
+std::vector<std::string> const& generatorNames();
+
+} // namespace graphgen
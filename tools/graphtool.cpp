@@ -0,0 +1,509 @@
+// graphtool - headless companion of nodegrapher
+// loads / saves graphs through the graph model only (no window, no GPU),
+// so that it can run on build servers against production graphs.
+
+#include "../layout.h"
+#include "../nodegraph.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using editorui::Graph;
+using editorui::NodePin;
+
+namespace {
+
+enum class Format
+{
+  JSON,
+  CBOR,
+  MSGPACK,
+  UBJSON,
+  BSON,
+};
+
+Format formatOf(std::string const& path)
+{
+  auto dot = path.rfind('.');
+  auto ext = dot == std::string::npos ? std::string() : path.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+    return char(std::tolower(c));
+  });
+  if (ext == "cbor")
+    return Format::CBOR;
+  if (ext == "msgpack" || ext == "mp")
+    return Format::MSGPACK;
+  if (ext == "ubjson" || ext == "ubj")
+    return Format::UBJSON;
+  if (ext == "bson")
+    return Format::BSON;
+  return Format::JSON;
+}
+
+bool readDocument(std::string const& path, nlohmann::json& doc)
+{
+  std::ifstream ifile(path, std::ios::binary);
+  if (!ifile) {
+    fprintf(stderr, "cannot open \"%s\" for reading\n", path.c_str());
+    return false;
+  }
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(ifile)),
+                             std::istreambuf_iterator<char>());
+  try {
+    switch (formatOf(path)) {
+    case Format::CBOR:
+      doc = nlohmann::json::from_cbor(bytes);
+      break;
+    case Format::MSGPACK:
+      doc = nlohmann::json::from_msgpack(bytes);
+      break;
+    case Format::UBJSON:
+      doc = nlohmann::json::from_ubjson(bytes);
+      break;
+    case Format::BSON:
+      doc = nlohmann::json::from_bson(bytes);
+      break;
+    case Format::JSON:
+    default:
+      doc = nlohmann::json::parse(bytes.begin(), bytes.end());
+      break;
+    }
+  } catch (std::exception const& e) {
+    fprintf(stderr, "failed to parse \"%s\": %s\n", path.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
+
+bool writeDocument(std::string const& path, nlohmann::json const& doc, int indent)
+{
+  std::vector<uint8_t> bytes;
+  switch (formatOf(path)) {
+  case Format::CBOR:
+    bytes = nlohmann::json::to_cbor(doc);
+    break;
+  case Format::MSGPACK:
+    bytes = nlohmann::json::to_msgpack(doc);
+    break;
+  case Format::UBJSON:
+    bytes = nlohmann::json::to_ubjson(doc);
+    break;
+  case Format::BSON:
+    bytes = nlohmann::json::to_bson(doc);
+    break;
+  case Format::JSON:
+  default: {
+    auto const str = doc.dump(indent);
+    bytes.assign(str.begin(), str.end());
+  } break;
+  }
+  std::ofstream ofile(path, std::ios::binary);
+  if (!ofile) {
+    fprintf(stderr, "cannot open \"%s\" for writing\n", path.c_str());
+    return false;
+  }
+  ofile.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+  return bool(ofile);
+}
+
+bool loadGraph(Graph& graph, nlohmann::json const& doc)
+{
+  if (!doc.is_object() || doc.find("uigraph") == doc.end()) {
+    fprintf(stderr, "document has no \"uigraph\" section\n");
+    return false;
+  }
+  try {
+    // empty path: do not record history for tool loads
+    graph.load(doc, "");
+  } catch (std::exception const& e) {
+    fprintf(stderr, "failed to load graph: %s\n", e.what());
+    return false;
+  }
+  return true;
+}
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// commands {{{
+int stats(std::string const& path, bool asJson)
+{
+  nlohmann::json doc;
+  Graph          graph;
+  if (!readDocument(path, doc) || !loadGraph(graph, doc))
+    return 1;
+
+  std::unordered_map<size_t, size_t> indegree, outdegree;
+  size_t                             pathPoints = 0;
+  for (auto const& link : graph.links()) {
+    ++indegree[link.first.nodeIndex];
+    ++outdegree[link.second.nodeIndex];
+  }
+  for (auto const& path : graph.linkPathes())
+    pathPoints += path.second.size();
+
+  size_t maxIn = 0, maxOut = 0, sources = 0, sinks = 0, isolated = 0;
+  for (auto const& n : graph.nodes()) {
+    size_t const in  = indegree.count(n.first) ? indegree[n.first] : 0;
+    size_t const out = outdegree.count(n.first) ? outdegree[n.first] : 0;
+    maxIn            = std::max(maxIn, in);
+    maxOut           = std::max(maxOut, out);
+    sources += in == 0 && out > 0;
+    sinks += out == 0 && in > 0;
+    isolated += in == 0 && out == 0;
+  }
+  size_t const nodeCount = graph.nodes().size();
+  double const avgDegree = nodeCount ? 2.0 * graph.links().size() / nodeCount : 0.0;
+
+  auto const   memory     = graph.memoryUsage();
+  size_t const nodeBytes  = memory.nodes;
+  size_t const linkBytes  = memory.links;
+  size_t const pathBytes  = memory.linkPaths;
+  size_t const orderBytes = memory.nodeOrder;
+
+  if (asJson) {
+    nlohmann::json result = {
+        {"file", path},
+        {"nodes", nodeCount},
+        {"links", graph.links().size()},
+        {"sources", sources},
+        {"sinks", sinks},
+        {"isolated", isolated},
+        {"maxInDegree", maxIn},
+        {"maxOutDegree", maxOut},
+        {"avgDegree", avgDegree},
+        {"linkPathPoints", pathPoints},
+        {"memory",
+         {{"nodes", nodeBytes},
+          {"links", linkBytes},
+          {"linkPathes", pathBytes},
+          {"order", orderBytes},
+          {"total", nodeBytes + linkBytes + pathBytes + orderBytes}}},
+    };
+    printf("%s\n", result.dump(2).c_str());
+  } else {
+    printf("file             : %s\n", path.c_str());
+    printf("nodes            : %zu\n", nodeCount);
+    printf("links            : %zu\n", graph.links().size());
+    printf("sources / sinks  : %zu / %zu\n", sources, sinks);
+    printf("isolated nodes   : %zu\n", isolated);
+    printf("max in degree    : %zu\n", maxIn);
+    printf("max out degree   : %zu\n", maxOut);
+    printf("avg degree       : %.3f\n", avgDegree);
+    printf("link path points : %zu\n", pathPoints);
+    printf("memory (approx.) :\n");
+    printf("  nodes          : %zu bytes\n", nodeBytes);
+    printf("  links          : %zu bytes\n", linkBytes);
+    printf("  link pathes    : %zu bytes\n", pathBytes);
+    printf("  order          : %zu bytes\n", orderBytes);
+    printf("  total          : %zu bytes\n", nodeBytes + linkBytes + pathBytes + orderBytes);
+  }
+  return 0;
+}
+
+// checks what Graph::load made of a document: dangling links dropped, all others with a path
+// and the geometry built from them, so that a broken file cannot take the editor down
+size_t checkLoaded(std::string const& path, nlohmann::json const& doc)
+{
+  Graph graph;
+  if (!loadGraph(graph, doc))
+    return 1;
+  size_t errors = 0;
+  auto   error  = [&errors, &path](std::string const& msg) {
+    fprintf(stderr, "%s: loaded graph: %s\n", path.c_str(), msg.c_str());
+    ++errors;
+  };
+  for (auto const& link : graph.links()) {
+    auto const where = "link into " + std::to_string(link.first.nodeIndex) + "." +
+                       std::to_string(link.first.pinNumber) + ": ";
+    auto const built = graph.linkPathes().find(link.first);
+    if (!graph.nodes().count(link.first.nodeIndex) || !graph.nodes().count(link.second.nodeIndex))
+      error(where + "dangling");
+    else if (built == graph.linkPathes().end() || built->second.empty())
+      error(where + "no path");
+  }
+  try {
+    graph.geometry();
+  } catch (std::exception const& e) {
+    error(std::string("geometry failed: ") + e.what());
+  }
+  return errors;
+}
+
+// validates the document itself, then the graph loaded from it:
+// Graph::load drops dangling links, which the document checks still report
+int validate(std::string const& path)
+{
+  nlohmann::json doc;
+  if (!readDocument(path, doc))
+    return 1;
+  if (!doc.is_object() || doc.find("uigraph") == doc.end()) {
+    fprintf(stderr, "%s: no \"uigraph\" section\n", path.c_str());
+    return 1;
+  }
+
+  struct PinCounts
+  {
+    int inputs, outputs;
+  };
+  std::unordered_map<size_t, PinCounts> nodes;
+  std::unordered_map<NodePin, size_t>   linkedInputs;
+  size_t                                errors = 0;
+  auto error = [&errors, &path](std::string const& msg) {
+    fprintf(stderr, "%s: %s\n", path.c_str(), msg.c_str());
+    ++errors;
+  };
+
+  auto const& uigraph = doc["uigraph"];
+  try {
+    for (auto const& n : uigraph.value("nodes", nlohmann::json::array())) {
+      size_t const id = n.at("id");
+      if (!nodes.insert({id, {n.at("maxInputs"), n.at("nOutputs")}}).second)
+        error("duplicated node id " + std::to_string(id));
+    }
+    size_t linkIndex = 0;
+    for (auto const& link : uigraph.value("links", nlohmann::json::array())) {
+      size_t const from    = link.at("from").at("node");
+      int const    fromPin = link.at("from").at("pin");
+      size_t const to      = link.at("to").at("node");
+      int const    toPin   = link.at("to").at("pin");
+      auto const   where   = "link #" + std::to_string(linkIndex++) + " (" +
+                         std::to_string(from) + "." + std::to_string(fromPin) + " -> " +
+                         std::to_string(to) + "." + std::to_string(toPin) + "): ";
+      auto fromitr = nodes.find(from), toitr = nodes.find(to);
+      if (fromitr == nodes.end())
+        error(where + "source node does not exist");
+      else if (fromPin < 0 || fromPin >= fromitr->second.outputs)
+        error(where + "source pin out of range, node has " +
+              std::to_string(fromitr->second.outputs) + " outputs");
+      if (toitr == nodes.end())
+        error(where + "destiny node does not exist");
+      else if (toPin < 0 || toPin >= toitr->second.inputs)
+        error(where + "destiny pin out of range, node has " +
+              std::to_string(toitr->second.inputs) + " inputs");
+      if (++linkedInputs[NodePin{NodePin::INPUT, to, toPin}] == 2)
+        error(where + "input pin has more than one source");
+    }
+    if (uigraph.find("order") != uigraph.end()) {
+      std::unordered_map<size_t, int> seen;
+      for (size_t id : uigraph["order"]) {
+        if (nodes.find(id) == nodes.end())
+          error("order refers to missing node " + std::to_string(id));
+        else if (++seen[id] == 2)
+          error("node " + std::to_string(id) + " appears more than once in order");
+      }
+      if (seen.size() != nodes.size())
+        error("order lists " + std::to_string(seen.size()) + " of " +
+              std::to_string(nodes.size()) + " nodes");
+    }
+  } catch (std::exception const& e) {
+    error(std::string("malformed document: ") + e.what());
+  }
+  errors += checkLoaded(path, doc);
+
+  if (errors == 0)
+    printf("%s: ok (%zu nodes, %zu links)\n", path.c_str(), nodes.size(), linkedInputs.size());
+  else
+    printf("%s: %zu error(s)\n", path.c_str(), errors);
+  return errors == 0 ? 0 : 2;
+}
+
+int convert(std::string const& input, std::string const& output, int indent)
+{
+  nlohmann::json doc;
+  Graph          graph;
+  if (!readDocument(input, doc) || !loadGraph(graph, doc))
+    return 1;
+  nlohmann::json result;
+  if (!graph.save(result, output))
+    return 1;
+  // keep foreign (hook) sections as they are, only the ui graph is re-generated
+  for (auto itr = doc.begin(); itr != doc.end(); ++itr)
+    if (itr.key() != "uigraph")
+      result[itr.key()] = itr.value();
+  return writeDocument(output, result, indent) ? 0 : 1;
+}
+
+int layoutGraph(std::string const& input, std::string const& output, bool force, int indent)
+{
+  nlohmann::json doc;
+  Graph          graph;
+  if (!readDocument(input, doc) || !loadGraph(graph, doc))
+    return 1;
+  if (force) {
+    auto const   start = std::chrono::steady_clock::now();
+    size_t const ticks = editorui::layout::force(graph);
+    printf("force layout settled after %zu ticks, %.1f ms\n", ticks, msSince(start));
+  } else {
+    auto const stats = editorui::layout::layered(graph);
+    printf("%zu layers, %zu dummies, %zu reversed links, crossings %zu -> %zu, %.1f ms\n",
+           stats.layers,
+           stats.dummies,
+           stats.reversed,
+           stats.crossingsBefore,
+           stats.crossings,
+           stats.ms);
+  }
+  nlohmann::json result;
+  if (!graph.save(result, output))
+    return 1;
+  for (auto itr = doc.begin(); itr != doc.end(); ++itr)
+    if (itr.key() != "uigraph")
+      result[itr.key()] = itr.value();
+  return writeDocument(output, result, indent) ? 0 : 1;
+}
+
+int bench(std::string const& path, int iterations)
+{
+  struct Phase
+  {
+    char const*         name;
+    std::vector<double> samples;
+
+    explicit Phase(char const* name) : name(name) {}
+  };
+  Phase parse{"parse"}, load{"load"}, pathgen{"genLinkPath"}, save{"save"}, dump{"dump"};
+
+  for (int i = 0; i < iterations; ++i) {
+    nlohmann::json doc;
+    auto           start = std::chrono::steady_clock::now();
+    if (!readDocument(path, doc))
+      return 1;
+    parse.samples.push_back(msSince(start));
+
+    Graph graph;
+    start = std::chrono::steady_clock::now();
+    if (!loadGraph(graph, doc))
+      return 1;
+    load.samples.push_back(msSince(start));
+
+    size_t points = 0;
+    start         = std::chrono::steady_clock::now();
+    for (auto const& link : graph.links()) {
+      auto const& src = graph.noderef(link.second.nodeIndex);
+      auto const& dst = graph.noderef(link.first.nodeIndex);
+      points += Graph::genLinkPath(src.outputPinPos(link.second.pinNumber),
+                                   dst.inputPinPos(link.first.pinNumber),
+                                   std::min(src.size().x, dst.size().x))
+                    .size();
+    }
+    pathgen.samples.push_back(msSince(start));
+
+    nlohmann::json saved;
+    start = std::chrono::steady_clock::now();
+    graph.save(saved, "");
+    save.samples.push_back(msSince(start));
+
+    start    = std::chrono::steady_clock::now();
+    auto str = saved.dump();
+    dump.samples.push_back(msSince(start));
+    (void)points;
+  }
+
+  printf("%-12s %10s %10s %10s\n", "phase", "min(ms)", "mean(ms)", "max(ms)");
+  for (auto* phase : {&parse, &load, &pathgen, &save, &dump}) {
+    auto const& s   = phase->samples;
+    double      sum = 0;
+    for (double v : s)
+      sum += v;
+    printf("%-12s %10.3f %10.3f %10.3f\n",
+           phase->name,
+           *std::min_element(s.begin(), s.end()),
+           sum / s.size(),
+           *std::max_element(s.begin(), s.end()));
+  }
+  return 0;
+}
+// commands }}}
+
+// the whole of text as a number, false if it is not one or out of range
+bool parseInt(std::string const& text, int& value)
+{
+  char* end = nullptr;
+  errno     = 0;
+  long const v = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX)
+    return false;
+  value = int(v);
+  return true;
+}
+
+void usage()
+{
+  printf("usage:\n"
+         "  graphtool stats <file> [--json]           node / link / degree / memory statistics\n"
+         "  graphtool validate <file>                 check links against nodes and pin counts\n"
+         "  graphtool convert <in> <out> [--indent N] convert by extension\n"
+         "                                            (.json .cbor .msgpack .ubjson .bson)\n"
+         "  graphtool layout <in> <out> [--indent N]  layered layout, top to bottom\n"
+         "                  [--force]                 force-directed instead\n"
+         "  graphtool bench <file> [-n iterations]    time parse, load, genLinkPath, save, dump\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> args(argv + 1, argv + argc);
+  if (args.size() < 2) {
+    usage();
+    return 1;
+  }
+  auto option = [&args](char const* name) -> std::string const* {
+    auto itr = std::find(args.begin(), args.end(), name);
+    if (itr == args.end() || ++itr == args.end())
+      return nullptr;
+    return &*itr;
+  };
+
+  // value of an integer option, or fallback when not given; false if given but not a number
+  auto intOption = [&option](char const* name, int fallback, int& value) {
+    value           = fallback;
+    auto const* arg = option(name);
+    if (arg && !parseInt(*arg, value)) {
+      fprintf(stderr, "%s expects a number, got \"%s\"\n", name, arg->c_str());
+      return false;
+    }
+    return true;
+  };
+
+  auto const& command = args[0];
+  if (command == "stats") {
+    return stats(args[1], std::find(args.begin(), args.end(), "--json") != args.end());
+  } else if (command == "validate") {
+    int result = 0;
+    for (size_t i = 1; i < args.size(); ++i)
+      result = std::max(result, validate(args[i]));
+    return result;
+  } else if (command == "convert" && args.size() >= 3) {
+    int indent = 2;
+    if (intOption("--indent", 2, indent))
+      return convert(args[1], args[2], indent);
+  } else if (command == "layout" && args.size() >= 3) {
+    int        indent = 2;
+    bool const force  = std::find(args.begin(), args.end(), "--force") != args.end();
+    if (intOption("--indent", 2, indent))
+      return layoutGraph(args[1], args[2], force, indent);
+  } else if (command == "bench") {
+    int iterations = 5;
+    if (intOption("-n", 5, iterations))
+      return bench(args[1], std::max(1, iterations));
+  }
+  usage();
+  return 1;
+}
@@ -0,0 +1,559 @@
+// renderbench - rendering scenarios for updateNetworkView / drawGraph on synthetic graphs
+// each scenario runs on a fresh headless ImGui context for a fixed number of frames,
+// and reports where the time went (hit-testing, links, nodes, hook overlays) along with
+// the emitted geometry, so that renderer changes can be judged on the same scenes
+// nodes are reported inclusive of their shapes, pins & text, which are scopes of their own
+// links & nodes are drawn while the static layer records, which is reported as a whole too,
+// steady frames only replay it (layer), see --no-cache to draw everything every frame
+
+#include "../nodegraph.h"
+#include "../profiler.h"
+#include "graphgen.h"
+
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using editorui::BulkGraphData;
+using editorui::Graph;
+using editorui::GraphView;
+using editorui::Node;
+namespace profiler = editorui::profiler;
+
+namespace {
+
+char const* const WINDOW_NAME = "Network##renderbench";
+
+struct Config
+{
+  std::string           generator = "dag";
+  size_t                nodes     = 10000;
+  int                   frames    = 120;
+  int                   warmup    = 5;     // untimed frames after scenario setup, at least 2
+  int                   width     = 1600;
+  int                   height    = 900;
+  size_t                selection = 1000;  // dragged nodes in the drag scenario
+  bool                  hook      = true;  // install the overlay drawing hook
+  bool                  bundling  = false; // see Graph::setLinkBundling()
+  bool                  cache     = true;  // see editorui::setCacheStaticLayer()
+  std::set<std::string> scenarios;         // empty: all
+};
+
+// draws a badge on every node and a caption over the graph,
+// stands in for the overlays real hooks draw
+class OverlayHook : public editorui::NodeGraphHook
+{
+public:
+  void onNodeDraw(Node const* node, GraphView const& gv) override
+  {
+    auto const corner =
+        gv.canvasToScreen * glm::vec3(node->pos() + node->size() * glm::vec2(0.5f, -0.5f), 1);
+    ImGui::GetWindowDrawList()->AddCircleFilled(
+        ImVec2(corner.x, corner.y), 3 * gv.canvasScale, IM_COL32(255, 180, 0, 255), 8);
+  }
+
+  void onGraphDraw(Graph const* host, GraphView const& gv) override
+  {
+    auto const pos = ImGui::GetWindowPos();
+    ImGui::GetWindowDrawList()->AddText(ImVec2(pos.x + 8, pos.y + 8),
+                                        IM_COL32(255, 255, 255, 200),
+                                        "renderbench");
+  }
+};
+
+struct Session
+{
+  Config const&          cfg;
+  std::unique_ptr<Graph> graph;
+  GraphView*             view   = nullptr;
+  ImVec2                 anchor = {0, 0}; // screen position a scenario holds on to
+};
+
+struct Scenario
+{
+  char const* name;
+  char const* description;
+  // runs once after the first frame, the view is framed on the whole graph by then
+  std::function<void(Session&)> setup;
+  // feeds mouse & keyboard state of given frame, counted from the end of setup
+  std::function<void(Session&, int, ImGuiIO&)> input;
+};
+
+ImVec2 toScreen(GraphView const& gv, glm::vec2 const& pt)
+{
+  auto const p = gv.canvasToScreen * glm::vec3(pt, 1);
+  return ImVec2(p.x, p.y);
+}
+
+void lookAt(GraphView& gv, glm::vec2 const& center, float scale)
+{
+  gv.canvasOffset = -center;
+  gv.canvasScale  = scale;
+}
+
+glm::vec2 graphCenter(Graph const& graph)
+{
+  glm::vec2 lo(1e30f), hi(-1e30f);
+  for (auto const& n : graph.nodes()) {
+    lo = glm::min(lo, n.second.pos());
+    hi = glm::max(hi, n.second.pos());
+  }
+  return (lo + hi) * 0.5f;
+}
+
+float segmentDistance(glm::vec2 const& p, glm::vec2 const& a, glm::vec2 const& b)
+{
+  glm::vec2 const ab = b - a;
+  float const     len2 = glm::dot(ab, ab);
+  float const     t    = len2 > 0 ? glm::clamp(glm::dot(p - a, ab) / len2, 0.f, 1.f) : 0.f;
+  return glm::length(p - (a + ab * t));
+}
+
+// a canvas position near `around` that is neither on a node nor on a link,
+// so that pressing the mouse there neither grabs a node nor a link body
+glm::vec2 findEmptySpot(Graph const& graph, glm::vec2 const& around)
+{
+  auto const empty = [&graph](glm::vec2 const& p) {
+    for (auto const& n : graph.nodes()) {
+      glm::vec2 const half = n.second.size() * 0.5f + glm::vec2(16);
+      if (glm::all(glm::lessThan(glm::abs(p - n.second.pos()), half)))
+        return false;
+    }
+    for (auto const& lp : graph.linkPathes())
+      for (size_t i = 1; i < lp.second.size(); ++i)
+        if (segmentDistance(p, lp.second[i - 1], lp.second[i]) < 12)
+          return false;
+    return true;
+  };
+  for (int ring = 0; ring < 64; ++ring)
+    for (int k = 0; k < std::max(1, ring * 8); ++k) {
+      float const     angle = k * 6.2831853f / std::max(1, ring * 8);
+      glm::vec2 const p     = around + glm::vec2(std::cos(angle), std::sin(angle)) * (ring * 12.f);
+      if (empty(p))
+        return p;
+    }
+  return around;
+}
+
+void hover(Session& s, int, ImGuiIO& io)
+{
+  io.MousePos = ImVec2(s.cfg.width * 0.5f, s.cfg.height * 0.5f);
+}
+
+std::vector<Scenario> scenarios()
+{
+  std::vector<Scenario> list;
+  list.push_back({"overview", "whole graph framed, nothing selected", [](Session&) {}, hover});
+  list.push_back({"corner",
+                  "zoomed in (x2) on the top left corner of the graph",
+                  [](Session& s) {
+                    glm::vec2 lo(1e30f);
+                    for (auto const& n : s.graph->nodes())
+                      lo = glm::min(lo, n.second.pos());
+                    float const     scale = 2.f;
+                    glm::vec2 const half  = s.view->canvasSize * 0.5f / scale;
+                    lookAt(*s.view, lo + half - glm::vec2(40), scale);
+                  },
+                  hover});
+  list.push_back({"denseLinks",
+                  "zoomed out (x0.5) around the node with most links",
+                  [](Session& s) {
+                    std::unordered_map<size_t, size_t> degree;
+                    for (auto const& link : s.graph->links()) {
+                      ++degree[link.first.nodeIndex];
+                      ++degree[link.second.nodeIndex];
+                    }
+                    auto const busiest = std::max_element(
+                        degree.begin(), degree.end(), [](auto const& a, auto const& b) {
+                          return a.second < b.second;
+                        });
+                    if (busiest != degree.end())
+                      lookAt(*s.view, s.graph->noderef(busiest->first).pos(), 0.5f);
+                  },
+                  hover});
+  list.push_back({"largeSelection",
+                  "whole graph framed, every node selected",
+                  [](Session& s) {
+                    for (auto const& n : s.graph->nodes())
+                      s.view->nodeSelection.insert(n.first);
+                  },
+                  hover});
+  list.push_back({"drag",
+                  "whole graph framed, dragging the selected nodes around the center",
+                  [](Session& s) {
+                    glm::vec2 const     center = -s.view->canvasOffset;
+                    std::vector<size_t> ids    = s.graph->order();
+                    std::sort(ids.begin(), ids.end(), [&](size_t a, size_t b) {
+                      return glm::distance(s.graph->noderef(a).pos(), center) <
+                             glm::distance(s.graph->noderef(b).pos(), center);
+                    });
+                    ids.resize(std::min(ids.size(), s.cfg.selection));
+                    s.view->nodeSelection = std::set<size_t>(ids.begin(), ids.end());
+                  },
+                  [](Session& s, int frame, ImGuiIO& io) {
+                    // grab the selected node closest to the center, then circle around
+                    if (frame <= 1 && !s.view->nodeSelection.empty()) {
+                      glm::vec2 const center  = -s.view->canvasOffset;
+                      size_t          closest = *s.view->nodeSelection.begin();
+                      for (size_t id : s.view->nodeSelection)
+                        if (glm::distance(s.graph->noderef(id).pos(), center) <
+                            glm::distance(s.graph->noderef(closest).pos(), center))
+                          closest = id;
+                      s.anchor = toScreen(*s.view, s.graph->noderef(closest).pos());
+                    }
+                    float const t = frame * 0.1f;
+                    io.MousePos   = frame <= 1 ? s.anchor
+                                               : ImVec2(s.anchor.x + 30 * std::sin(t),
+                                                      s.anchor.y + 30 - 30 * std::cos(t));
+                    io.MouseDown[0] = frame >= 1;
+                  }});
+  list.push_back({"cut",
+                  "zoomed to x1 at the graph center, drawing a link cutting stroke",
+                  [](Session& s) {
+                    lookAt(*s.view, findEmptySpot(*s.graph, graphCenter(*s.graph)), 1.f);
+                  },
+                  [](Session& s, int frame, ImGuiIO& io) {
+                    // press on the empty spot at the center, then zigzag with Y held
+                    ImVec2 const center(s.cfg.width * 0.5f, s.cfg.height * 0.5f);
+                    float const  t = std::max(0, frame - 1) * 0.3f;
+                    io.MousePos =
+                        ImVec2(center.x + 200 * std::sin(t), center.y + 150 * std::sin(t * 0.13f));
+                    io.MouseDown[0]                  = frame >= 1;
+                    io.KeysDown[io.KeyMap[ImGuiKey_Y]] = true;
+                  }});
+  return list;
+}
+
+struct Report
+{
+  std::string                     scenario;
+  std::string                     description;
+  int                             frames = 0;
+  std::vector<double>             frameMs; // wall time of updateNetworkView
+  double                          vertices = 0, indices = 0;
+  std::vector<profiler::PhaseTotal> phases;
+};
+
+double percentile(std::vector<double> values, double p)
+{
+  if (values.empty())
+    return 0;
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, size_t(p * (values.size() - 1) + 0.5))];
+}
+
+Report run(Config const& cfg, BulkGraphData const& data, Scenario const& scenario)
+{
+  ImGui::CreateContext();
+  ImGuiIO& io                = ImGui::GetIO();
+  io.IniFilename             = nullptr;
+  io.DisplaySize             = ImVec2(float(cfg.width), float(cfg.height));
+  io.DeltaTime               = 1.f / 60.f;
+  io.KeyMap[ImGuiKey_Y]      = 'Y';
+  io.BackendRendererName     = "null";
+  io.BackendFlags           |= ImGuiBackendFlags_RendererHasVtxOffset;
+  editorui::init();
+  editorui::setCacheStaticLayer(cfg.cache);
+  unsigned char* pixels = nullptr;
+  int            texWidth = 0, texHeight = 0;
+  io.Fonts->GetTexDataAsRGBA32(&pixels, &texWidth, &texHeight);
+  io.Fonts->SetTexID(ImTextureID(intptr_t(1)));
+
+  OverlayHook hook;
+  Session     session = {cfg, std::make_unique<Graph>()};
+  if (cfg.hook)
+    session.graph->setHook(&hook);
+  session.graph->importBulk(data);
+  session.graph->setLinkBundling(cfg.bundling);
+  session.view             = session.graph->addViewer(GraphView::Kind::NETWORK);
+  session.view->needsFocus = true;
+
+  Report report;
+  report.scenario    = scenario.name;
+  report.description = scenario.description;
+  auto const frame = [&](int inputFrame, bool timed) {
+    for (auto& down : io.MouseDown)
+      down = false;
+    for (auto& down : io.KeysDown)
+      down = false;
+    io.MouseWheel = 0;
+    if (inputFrame >= 0)
+      scenario.input(session, inputFrame, io);
+    else
+      hover(session, inputFrame, io);
+
+    ImGui::NewFrame();
+    profiler::beginFrame();
+    ImGui::SetWindowPos(WINDOW_NAME, ImVec2(0, 0));
+    ImGui::SetWindowSize(WINDOW_NAME, io.DisplaySize);
+    double const start = profiler::now();
+    editorui::updateNetworkView(*session.view, WINDOW_NAME);
+    double const elapsed = profiler::now() - start;
+    profiler::endFrame();
+    ImGui::Render();
+
+    if (timed) {
+      auto const* drawData = ImGui::GetDrawData();
+      report.frameMs.push_back(elapsed);
+      report.vertices += drawData->TotalVtxCount;
+      report.indices += drawData->TotalIdxCount;
+    }
+  };
+
+  // the first two frames create & size the window and frame the graph
+  frame(-1, false);
+  frame(-1, false);
+  scenario.setup(session);
+  int inputFrame = 0;
+  for (int i = 0; i < std::max(2, cfg.warmup); ++i)
+    frame(inputFrame++, false);
+  profiler::reset();
+  for (int i = 0; i < cfg.frames; ++i)
+    frame(inputFrame++, true);
+
+  report.frames = cfg.frames;
+  report.phases = profiler::totals();
+  session.graph.reset();
+  ImGui::DestroyContext();
+  return report;
+}
+
+profiler::PhaseTotal phase(Report const& r, char const* name)
+{
+  for (auto const& p : r.phases)
+    if (std::string(p.name) == name)
+      return p;
+  profiler::PhaseTotal none;
+  none.name = name;
+  return none;
+}
+
+template<class T, class Parse>
+std::vector<T> splitList(std::string const& str, Parse parse)
+{
+  std::vector<T>    result;
+  std::stringstream ss(str);
+  std::string       item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      result.push_back(parse(item));
+  return result;
+}
+
+// the whole of text as a count, with an optional k or M suffix (1k = 1000), false if it is
+// not one or above max
+bool parseCount(std::string const& text, size_t& value, size_t max = size_t(-1))
+{
+  if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+    return false; // strtoull would take leading blanks & signs
+  char* end = nullptr;
+  errno     = 0;
+  unsigned long long const v     = std::strtoull(text.c_str(), &end, 10);
+  unsigned long long       scale = 1;
+  if (*end == 'k')
+    scale = 1000, ++end;
+  else if (*end == 'M')
+    scale = 1000000, ++end;
+  if (*end != '\0' || errno == ERANGE || v > max / scale)
+    return false;
+  value = size_t(v * scale);
+  return true;
+}
+
+void usage()
+{
+  printf("usage: renderbench [options]\n"
+         "  --generator dag          chain tree fanout dag grid\n"
+         "  --nodes N                node count, 10k for 10000 (10000)\n"
+         "  --frames N               timed frames per scenario (120)\n"
+         "  --warmup N               untimed frames per scenario (5)\n"
+         "  --size WxH               display size (1600x900)\n"
+         "  --selection N            dragged nodes in the drag scenario (1000)\n"
+         "  --scenarios a,b,...      ");
+  for (auto const& s : scenarios())
+    printf("%s ", s.name);
+  printf("\n"
+         "  --no-hook                do not install the overlay drawing hook\n"
+         "  --bundling               draw links of busy output pins as bundles\n"
+         "  --no-cache               draw everything every frame, no static layer\n"
+         "  --out file.json          write results there instead of stdout\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  Config      cfg;
+  std::string outPath;
+  auto const  bad = [](std::string const& option, std::string const& value) {
+    fprintf(stderr, "%s expects a number, got \"%s\"\n", option.c_str(), value.c_str());
+    usage();
+    return 1;
+  };
+  // frame counts are ints, at least low
+  auto const frameCount = [](std::string const& text, int& value, int low) {
+    size_t n = 0;
+    if (!parseCount(text, n, INT_MAX))
+      return false;
+    value = std::max(low, int(n));
+    return true;
+  };
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg  = argv[i];
+    bool const        more = i + 1 < argc;
+    if (arg == "--generator" && more)
+      cfg.generator = argv[++i];
+    else if (arg == "--nodes" && more) {
+      if (!parseCount(argv[++i], cfg.nodes))
+        return bad(arg, argv[i]);
+    } else if (arg == "--frames" && more) {
+      if (!frameCount(argv[++i], cfg.frames, 1))
+        return bad(arg, argv[i]);
+    } else if (arg == "--warmup" && more) {
+      if (!frameCount(argv[++i], cfg.warmup, 2))
+        return bad(arg, argv[i]);
+    } else if (arg == "--size" && more) {
+      char trailing; // anything after WxH
+      if (sscanf(argv[++i], "%dx%d%c", &cfg.width, &cfg.height, &trailing) != 2) {
+        usage();
+        return 1;
+      }
+    }
+    else if (arg == "--selection" && more) {
+      if (!parseCount(argv[++i], cfg.selection))
+        return bad(arg, argv[i]);
+    } else if (arg == "--scenarios" && more)
+      for (auto const& name :
+           splitList<std::string>(argv[++i], [](std::string const& s) { return s; }))
+        cfg.scenarios.insert(name);
+    else if (arg == "--no-hook")
+      cfg.hook = false;
+    else if (arg == "--bundling")
+      cfg.bundling = true;
+    else if (arg == "--no-cache")
+      cfg.cache = false;
+    else if (arg == "--out" && more)
+      outPath = argv[++i];
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  BulkGraphData data;
+  if (!graphgen::generate(cfg.generator, cfg.nodes, data)) {
+    fprintf(stderr, "unknown generator \"%s\"\n", cfg.generator.c_str());
+    return 1;
+  }
+
+  profiler::setEnabled(true);
+  std::vector<Report> reports;
+  for (auto const& scenario : scenarios()) {
+    if (!cfg.scenarios.empty() && !cfg.scenarios.count(scenario.name))
+      continue;
+    reports.push_back(run(cfg, data, scenario));
+    auto const& r = reports.back();
+    double const n = r.frames;
+    fprintf(stderr,
+            "%-15s frame %8.3f ms  hitTest %8.3f  links %8.3f  nodes %8.3f  record %8.3f  "
+            "layer %8.3f  overlays %8.3f  vtx %9.0f  idx %9.0f\n",
+            r.scenario.c_str(),
+            percentile(r.frameMs, 0.5),
+            phase(r, "updateNetworkView/hitTest").inclusiveMs / n,
+            phase(r, "drawGraph/links").inclusiveMs / n,
+            phase(r, "drawGraph/nodes").inclusiveMs / n,
+            phase(r, "drawGraph/staticLayer/record").inclusiveMs / n,
+            phase(r, "drawGraph/staticLayer").inclusiveMs / n,
+            phase(r, "drawGraph/hookOverlays").inclusiveMs / n,
+            r.vertices / n,
+            r.indices / n);
+  }
+
+  char       timestamp[32] = {0};
+  auto const now           = std::time(nullptr);
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  nlohmann::json result = {
+      {"benchmark", "renderbench"},
+      {"timestamp", timestamp},
+      {"config",
+       {{"generator", cfg.generator},
+        {"nodes", data.types.size()},
+        {"links", data.links.size()},
+        {"frames", cfg.frames},
+        {"warmup", cfg.warmup},
+        {"width", cfg.width},
+        {"height", cfg.height},
+        {"selection", cfg.selection},
+        {"hook", cfg.hook},
+        {"bundling", cfg.bundling},
+        {"cache", cfg.cache}}},
+      {"results", nlohmann::json::array()},
+  };
+  for (auto const& r : reports) {
+    double const   n = r.frames;
+    nlohmann::json phases = nlohmann::json::object();
+    for (auto const& p : r.phases) {
+      std::string const name = p.name;
+      // geometry counters are folded into the phase they were counted in
+      for (char const* suffix : {".vtx", ".idx"}) {
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, suffix) == 0) {
+          phases[name.substr(0, name.size() - 4)][suffix[1] == 'v' ? "vertices" : "indices"] =
+              p.counter / n;
+        }
+      }
+      if (name.find('.') != std::string::npos)
+        continue;
+      phases[name]["inclusiveMs"] = p.inclusiveMs / n;
+      phases[name]["exclusiveMs"] = p.exclusiveMs / n;
+      phases[name]["calls"]       = p.calls / n;
+    }
+    result["results"].push_back({
+        {"scenario", r.scenario},
+        {"description", r.description},
+        {"frameMs",
+         {{"mean", std::accumulate(r.frameMs.begin(), r.frameMs.end(), 0.0) / n},
+          {"p50", percentile(r.frameMs, 0.5)},
+          {"p95", percentile(r.frameMs, 0.95)},
+          {"max", percentile(r.frameMs, 1.0)}}},
+        {"split",
+         {{"hitTestMs", phase(r, "updateNetworkView/hitTest").inclusiveMs / n},
+          {"linksMs", phase(r, "drawGraph/links").inclusiveMs / n},
+          {"nodesMs", phase(r, "drawGraph/nodes").inclusiveMs / n},
+          {"staticLayerRecordMs", phase(r, "drawGraph/staticLayer/record").inclusiveMs / n},
+          {"staticLayerMs", phase(r, "drawGraph/staticLayer").inclusiveMs / n},
+          {"hookOverlaysMs", phase(r, "drawGraph/hookOverlays").inclusiveMs / n}}},
+        {"vertices", r.vertices / n},
+        {"indices", r.indices / n},
+        {"phases", phases},
+    });
+  }
+
+  if (outPath.empty()) {
+    printf("%s\n", result.dump(2).c_str());
+  } else {
+    std::ofstream ofile(outPath, std::ios::binary);
+    if (!ofile) {
+      fprintf(stderr, "cannot open \"%s\" for writing\n", outPath.c_str());
+      return 1;
+    }
+    ofile << result.dump(2) << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,248 @@
+#include "tracer.h"
+#include "profiler.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace editorui {
+namespace trace {
+
+namespace {
+
+struct Event
+{
+  char const* name;
+  double      us; // since start()
+  int64_t     value;
+  char        type; // trace-event phase: B, E, i or C
+};
+
+constexpr size_t CHUNK_EVENTS = 16384;
+constexpr size_t MAX_CHUNKS   = 1024; // 16M events per thread and recording
+
+// written by its own thread only; readers see events up to `size`, published with release
+// chunks are allocated on demand and kept for later recordings, until the thread exits
+struct ThreadBuffer
+{
+  int                                                tid     = 0;
+  uint32_t                                           session = 0; // owned by the writer
+  std::atomic<uint32_t>                              publishedSession = {0};
+  std::atomic<char const*>                           threadName       = {nullptr};
+  std::atomic<size_t>                                size             = {0};
+  std::atomic<size_t>                                dropped          = {0};
+  std::atomic<bool>                                  retired          = {false}; // thread exited
+  std::array<std::unique_ptr<Event[]>, MAX_CHUNKS> chunks;
+};
+
+struct State
+{
+  std::atomic<bool>                          recording = {false};
+  std::atomic<uint32_t>                      session   = {0};
+  std::atomic<double>                        originMs  = {0};
+  std::mutex                                 registryMutex; // only taken once per thread
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  int                                        lastTid = 0;
+};
+
+State& state()
+{
+  static State s;
+  return s;
+}
+
+// retires the buffer of the thread when it exits; its events stay until the next start()
+// frees it, so that short lived threads, e.g. of layouts or a toggled worker, do not pile up
+struct BufferOwner
+{
+  ThreadBuffer* buffer = nullptr;
+
+  ~BufferOwner()
+  {
+    if (buffer)
+      buffer->retired.store(true, std::memory_order_release);
+  }
+};
+
+thread_local BufferOwner tlsBuffer;
+
+ThreadBuffer& threadBuffer()
+{
+  if (!tlsBuffer.buffer) {
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.registryMutex);
+    s.buffers.push_back(std::make_unique<ThreadBuffer>());
+    tlsBuffer.buffer      = s.buffers.back().get();
+    tlsBuffer.buffer->tid = ++s.lastTid;
+  }
+  return *tlsBuffer.buffer;
+}
+
+void append(char type, char const* name, int64_t value)
+{
+  auto& s = state();
+  if (!s.recording.load(std::memory_order_relaxed) || !name)
+    return;
+  auto&          buf     = threadBuffer();
+  uint32_t const session = s.session.load(std::memory_order_acquire);
+  if (buf.session != session) { // first event of a new recording on this thread
+    buf.size.store(0, std::memory_order_relaxed);
+    buf.dropped.store(0, std::memory_order_relaxed);
+    buf.session = session;
+    buf.publishedSession.store(session, std::memory_order_release);
+  }
+  size_t const n = buf.size.load(std::memory_order_relaxed);
+  if (n >= CHUNK_EVENTS * MAX_CHUNKS) {
+    buf.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto& chunk = buf.chunks[n / CHUNK_EVENTS];
+  if (!chunk)
+    chunk.reset(new Event[CHUNK_EVENTS]);
+  double const us = (profiler::now() - s.originMs.load(std::memory_order_relaxed)) * 1000.0;
+  chunk[n % CHUNK_EVENTS] = {name, us, value, type};
+  buf.size.store(n + 1, std::memory_order_release);
+}
+
+// calls fn(buffer, eventCount) for each thread that recorded in the current session
+template<class Fn>
+void forEachBuffer(Fn&& fn)
+{
+  auto&                       s = state();
+  std::lock_guard<std::mutex> lock(s.registryMutex);
+  uint32_t const              session = s.session.load(std::memory_order_acquire);
+  for (auto const& buf : s.buffers)
+    if (buf->publishedSession.load(std::memory_order_acquire) == session)
+      fn(*buf, buf->size.load(std::memory_order_acquire));
+}
+
+} // namespace
+
+bool recording()
+{
+  return state().recording.load(std::memory_order_relaxed);
+}
+
+void start()
+{
+  auto& s = state();
+  {
+    std::lock_guard<std::mutex> lock(s.registryMutex);
+    s.buffers.erase(std::remove_if(s.buffers.begin(),
+                                   s.buffers.end(),
+                                   [](std::unique_ptr<ThreadBuffer> const& buf) {
+                                     return buf->retired.load(std::memory_order_acquire);
+                                   }),
+                    s.buffers.end());
+  }
+  s.originMs.store(profiler::now(), std::memory_order_relaxed);
+  s.session.fetch_add(1, std::memory_order_release);
+  s.recording.store(true, std::memory_order_release);
+}
+
+void stop()
+{
+  state().recording.store(false, std::memory_order_release);
+}
+
+size_t eventCount()
+{
+  size_t total = 0;
+  forEachBuffer([&total](ThreadBuffer const&, size_t size) { total += size; });
+  return total;
+}
+
+size_t droppedCount()
+{
+  size_t total = 0;
+  forEachBuffer([&total](ThreadBuffer const& buf, size_t) {
+    total += buf.dropped.load(std::memory_order_relaxed);
+  });
+  return total;
+}
+
+void begin(char const* name)
+{
+  append('B', name, 0);
+}
+
+void end(char const* name)
+{
+  append('E', name, 0);
+}
+
+void instant(char const* name)
+{
+  append('i', name, 0);
+}
+
+void counter(char const* name, int64_t value)
+{
+  append('C', name, value);
+}
+
+void setThreadName(char const* name)
+{
+  threadBuffer().threadName.store(name, std::memory_order_relaxed);
+}
+
+bool write(std::string const& path)
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file)
+    return false;
+
+  // names repeat a lot, escape each only once
+  std::map<char const*, std::string> escaped;
+  auto const quoted = [&escaped](char const* name) -> char const* {
+    auto& str = escaped[name];
+    if (str.empty())
+      str = nlohmann::json(name).dump();
+    return str.c_str();
+  };
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  forEachBuffer([&](ThreadBuffer const& buf, size_t size) {
+    if (char const* threadName = buf.threadName.load(std::memory_order_relaxed)) {
+      fprintf(file,
+              "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+              "\"args\":{\"name\":%s}}",
+              first ? "" : ",\n",
+              buf.tid,
+              quoted(threadName));
+      first = false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      auto const& e = buf.chunks[i / CHUNK_EVENTS][i % CHUNK_EVENTS];
+      fprintf(file,
+              "%s{\"name\":%s,\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+              first ? "" : ",\n",
+              quoted(e.name),
+              e.type,
+              e.us,
+              buf.tid);
+      if (e.type == 'C')
+        fprintf(file, ",\"args\":{\"value\":%lld}}", (long long)e.value);
+      else if (e.type == 'i')
+        fprintf(file, ",\"s\":\"t\"}");
+      else
+        fprintf(file, "}");
+      first = false;
+    }
+  });
+  fprintf(file, "\n]}\n");
+  bool const succeed = !ferror(file);
+  fclose(file);
+  return succeed;
+}
+
+} // namespace trace
+} // namespace editorui
@@ -0,0 +1,39 @@
+#pragma once
+// trace recorder writing Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev)
+// no ImGui in here - the model and headless tools use it too
+
+#include <cstdint>
+#include <string>
+
+namespace editorui {
+namespace trace {
+
+/// recording is off by default; start() drops events of the previous recording, and frees the
+/// buffers of threads that exited since
+bool recording();
+void start();
+void stop();
+
+/// writes events of the current or last recording, returns false if the file can not be written
+bool write(std::string const& path);
+
+/// events recorded so far, over all threads, and events dropped because buffers were full
+size_t eventCount();
+size_t droppedCount();
+
+/// names must outlive the recording (string literals or profiler phase names), the pointer
+/// is kept. each thread appends to its own buffer without locking, so these are cheap enough
+/// to call from anywhere, and no-ops while not recording
+void begin(char const* name);
+void end(char const* name);
+void instant(char const* name);
+void counter(char const* name, int64_t value);
+
+/// names the calling thread in the trace, e.g. "main" or "linkpath worker"
+void setThreadName(char const* name);
+
+/// environment variable holding a path: record from startup and write there on exit
+constexpr char const* ENV_VAR = "NODEGRAPH_TRACE";
+
+} // namespace trace
+} // namespace editorui
@@ -0,0 +1,115 @@
+#include "transform2d.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) ||                               \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NG_TRANSFORM2D_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NG_TARGET_AVX // MSVC compiles AVX intrinsics without extra flags
+#else
+#define NG_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace editorui {
+namespace transform2d {
+
+namespace {
+
+using Kernel = void (*)(float const*, float*, size_t, float, float, float);
+
+void scalar(float const* src, float* dst, size_t n, float scale, float dx, float dy)
+{
+  for (size_t i = 0; i < n; ++i) {
+    dst[2 * i]     = src[2 * i] * scale + dx;
+    dst[2 * i + 1] = src[2 * i + 1] * scale + dy;
+  }
+}
+
+#ifdef NG_TRANSFORM2D_SSE2
+// 2 points per register
+void sse2(float const* src, float* dst, size_t n, float scale, float dx, float dy)
+{
+  __m128 const s = _mm_set1_ps(scale);
+  __m128 const d = _mm_setr_ps(dx, dy, dx, dy);
+  size_t       i = 0;
+  for (; i + 4 <= n; i += 4) { // unrolled once, loads of both halves are independent
+    __m128 const a = _mm_loadu_ps(src + 2 * i);
+    __m128 const b = _mm_loadu_ps(src + 2 * i + 4);
+    _mm_storeu_ps(dst + 2 * i, _mm_add_ps(_mm_mul_ps(a, s), d));
+    _mm_storeu_ps(dst + 2 * i + 4, _mm_add_ps(_mm_mul_ps(b, s), d));
+  }
+  scalar(src + 2 * i, dst + 2 * i, n - i, scale, dx, dy);
+}
+
+// 4 points per register
+NG_TARGET_AVX void avx(float const* src, float* dst, size_t n, float scale, float dx, float dy)
+{
+  __m256 const s = _mm256_set1_ps(scale);
+  __m256 const d = _mm256_setr_ps(dx, dy, dx, dy, dx, dy, dx, dy);
+  size_t       i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 const a = _mm256_loadu_ps(src + 2 * i);
+    __m256 const b = _mm256_loadu_ps(src + 2 * i + 8);
+    _mm256_storeu_ps(dst + 2 * i, _mm256_add_ps(_mm256_mul_ps(a, s), d));
+    _mm256_storeu_ps(dst + 2 * i + 8, _mm256_add_ps(_mm256_mul_ps(b, s), d));
+  }
+  _mm256_zeroupper();
+  sse2(src + 2 * i, dst + 2 * i, n - i, scale, dx, dy);
+}
+
+bool cpuHasAvx()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  bool const osxsave = (info[2] >> 27) & 1;
+  bool const avx     = (info[2] >> 28) & 1;
+  // the OS must also save the upper halves of the ymm registers
+  return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#else
+  return __builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+struct Dispatch
+{
+  Kernel      kernel = scalar;
+  char const* name   = "scalar";
+
+  Dispatch()
+  {
+#ifdef NG_TRANSFORM2D_SSE2
+    if (cpuHasAvx()) {
+      kernel = avx;
+      name   = "avx";
+    } else {
+      kernel = sse2;
+      name   = "sse2";
+    }
+#endif
+  }
+};
+
+Dispatch const& dispatch()
+{
+  static Dispatch const d;
+  return d;
+}
+
+} // namespace
+
+void scaleTranslate(float const* src, float* dst, size_t n, float scale, float dx, float dy)
+{
+  dispatch().kernel(src, dst, n, scale, dx, dy);
+}
+
+char const* kernelName()
+{
+  return dispatch().name;
+}
+
+} // namespace transform2d
+} // namespace editorui
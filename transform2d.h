@@ -0,0 +1,18 @@
+#pragma once
+// bulk transforms of 2d points, vectorized with AVX or SSE where the CPU has them
+// no ImGui or glm in here - points are pairs of floats, as in glm::vec2 or ImVec2
+
+#include <cstddef>
+
+namespace editorui {
+namespace transform2d {
+
+/// dst[i] = src[i] * scale + offset for n points stored as x, y, x, y, ...
+/// src and dst may be the same array, but must not overlap otherwise
+void scaleTranslate(float const* src, float* dst, size_t n, float scale, float dx, float dy);
+
+/// instruction set picked at startup: "avx", "sse2" or "scalar"
+char const* kernelName();
+
+} // namespace transform2d
+} // namespace editorui